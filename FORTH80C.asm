@@ -46,17 +46,22 @@
 ; Return stack Pointer		RP	RPP (memory)
 ; Working register		W	DE
 ;
-; stack		:	|[INITS0-2] ... [IP+4] [IP+2] [IP]
-; return stack	:	|[INITR0-2] ... [RP+4] [RP+2] [RP]
+; stack		:	|[S0-2] ... [IP+4] [IP+2] [IP]
+; return stack	:	|[R0-2] ... [RP+4] [RP+2] [RP]
 ;
 ; ***** Memory Map *****
 ;
+; The area from TIB on is laid out downward from the TPA top
+; ( the BDOS base at 0006H ) by the cold start. For the TPA top
+; above LIMIT0, a half of the space over LIMIT0 goes to the buffers.
+;
 ;               |=======|
 ;        ORIG ->| 0100H |     program start
 ;               |   .   |
-;               |   .   |
+;          UP ->| 01B2H |     top of user variables area
+;               |   :   |
 ;               |=======|
-;       LIT-6 ->| 022AH |     start of dictionary
+;       LIT-6 ->| 058AH |     start of dictionary
 ;               |   .   |
 ;               |   .   |
 ;      INITDP ->| ????H |     initial position of DP
@@ -76,24 +81,24 @@
 ;               | ----- |
 ;          SP  ^|   .   |     stack pointer (go upper)
 ;               |   .   |
-;               | 7E16H |     bottom of stack
+;               | S0-2  |     bottom of stack
 ;               |=======|
-; INITS0, TIB ->| 7E18H |     terminal input buffer
+;     S0, TIB ->| R0-A0H|     terminal input buffer
 ;               |   .   |
 ;               |   .   |
 ;               | ----- |
 ;          RP  ^|   .   |     return stack pointer (go upper)
 ;               |   .   |
-;               | 7EB6H |     bottom of return stack
+;               | R0-2  |     bottom of return stack
 ;               |=======|
-;  INITR0, UP ->| 7EB8H |     top of user variables area
+;          R0 ->| ????H |     screen cache ( 1024 bytes )
 ;               |   :   |
 ;               |=======|
-;       FIRST ->| 7EF8H |     top of disk buffers
+;       FIRST ->| ????H |     top of disk buffers ( #BUFF buffers )
+;               |   :   |     ( 7780H for 8000H, A990H for E400H )
 ;               |   :   |
-;               | 7FFEH |     bottom of disk buffers
 ;               |=======|
-;       LIMIT ->| 8000H |     out of area
+;       LIMIT ->| ??00H |     out of area ( the TPA top, 256 aligned )
 ;
 ; ***** Disk Buffer's Structure *****
 ;
@@ -109,21 +114,24 @@
 ;               |           |   |
 ;               |-----------| -----
 ;               | 00H | 00H | double null charcters
+;               |-----------|
+;               |   next    | next buffer in the hash chain
+;               |-----------|
+;               | r   | 00H | r: reference flag (for the clock)
 ;               |===========|
 ;               | f |   n   |
 ;               |-----------| -----
-;               |           |   |
-;               |           |   |
-;               |           |   |
-;       buffer2 |    DATA   |  128 bytes
-;               ~           ~   |
-;               ~           ~   |
-;               |           |   |
-;               |-----------| -----
-;               | 00H | 00H |
+;               ~           ~
+;               ~           ~
 ;               |===========|
 ;       LIMIT ->
 ;
+; The buffers with the block number n are chained from
+; the n & (BHASH0 - 1)-th cell of BHTAB. The block number of
+; a buffer is changed only by (BLINK), which unlinks the buffer
+; from the chain of the old number ( UPDATE sets only the flag ).
+; EMPTY-BUFFERS clears the numbers and all the chains.
+;
 ; ========== ENVIRONMENT DEPENDENT ==========
 ;
 ; *** Floppy Disk Configuration (CP/M Ver 2.2 standard) ***
@@ -169,14 +177,13 @@ DOFSET	EQU	3	; offset for drive No. (0 = D:, 1 = E:)
 ORIG0	EQU	100H
 BBUF0	EQU	128		; bytes per buffer = BPS
 BSCR0	EQU	8		; blocks per screen
-BFLEN0	EQU	BBUF0+4		; buffer tags length = 4
-LIMIT0	EQU	8000H
-NUMBU0	EQU	2		; number of disk block buffers
-FIRST0	EQU	LIMIT0-BFLEN0*NUMBU0
-UP	EQU	FIRST0-40H	; user variables area size
-				;                        = 40H
-INITR0	EQU	UP
-INITS0	EQU	INITR0-0A0H	; return stack size = A0H
+BFLEN0	EQU	BBUF0+8		; buffer tags length = 8
+LIMIT0	EQU	8000H		; ( the TPA top for NUMBU0 )
+NUMBU0	EQU	16		; number of disk block buffers
+				;  ( at least )
+BHASH0	EQU	16		; block hash buckets (power of 2)
+RSSIZ0	EQU	0A0H		; return stack size
+OBLEN0	EQU	128		; console output buffer size
 ;
 MXTOKN	EQU	34		; max bytes of tokens
 				;  (On 2-base,
@@ -187,6 +194,25 @@ WRDBSZ	EQU	64+6		; word buffer size ( > C/L)
 PADSZ	EQU	80+1		; PAD size
 TMPBSZ	EQU	WRDBSZ+PADSZ	; temporary buffer area size
 ;
+TRUE	EQU	0FFFFH		; the values of the flags below
+FALSE	EQU	NOT TRUE
+;
+HASHED	EQU	TRUE		; hashed dictionary index
+				;  (FALSE = linear search only)
+NHASH0	EQU	32		; index buckets per vocabulary
+				;  (power of 2)
+NATIV0	EQU	TRUE		; NATIVE mode of colon definitions
+				;  (FALSE = indirect threading only)
+FUSE0	EQU	TRUE		; PEEPHOLE fusion of word pairs
+				;  (FALSE = none)
+PROF0	EQU	TRUE		; PROFILE of the calls per CFA
+				;  (FALSE = none)
+LITFS0	EQU	FALSE		; INTERPRET takes the tokens of digits
+				;  as numbers before searching
+				;  (FALSE = search first)
+QSTK0	EQU	TRUE		; INTERPRET checks the stack in a primitive
+				;  (FALSE = by the colon definition ?STACK)
+;
 ; ***************************************
 ;
 	ORG	100H
@@ -196,21 +222,65 @@ ORIG:	NOP
 	NOP
 	JMP	WRM
 ;
-RPP	DW	INITR0		; RETURN STACK POINTER
+RPP	DW	0		; RETURN STACK POINTER
 ;
 ; ***** COLD & WARM *****
 ;
 ; COLD START
 ;
-	; initialize IP
-CLD:	LXI	B,CLD1
+	; LIMIT <- the TPA top
+CLD:	LHLD	0006H	; HL <- the BDOS base
+	MVI	L,0
+	SHLD	LIMIT+2
+	; #BUFF <- NUMBU0 + ( LIMIT - LIMIT0 ) / BFLEN0 / 2
+	LXI	D,-LIMIT0
+	DAD	D
+	JC	CLD2
+	LXI	H,0	; ( LIMIT < LIMIT0 )
+CLD2:	MVI	E,BFLEN0
+	CALL	DIVE
+	MVI	E,2
+	CALL	DIVE
+	LXI	D,NUMBU0
+	DAD	D
+	SHLD	NUMBUF+2
+	; FIRST <- LIMIT - #BUFF * BFLEN0
+	XCHG
+	LHLD	LIMIT+2
+	LXI	B,-BFLEN0
+CLD3:	DAD	B
+	DCR	E
+	JNZ	CLD3
+	SHLD	FIRST+2
+	SHLD	USE+2
+	SHLD	PREV+2
+	; the screen cache, R0 <- FIRST - BSCR0 * BBUF0
+	LXI	D,-BSCR0*BBUF0
+	DAD	D
+	SHLD	PINA
+	SHLD	UVR+8
+	; S0, TIB <- R0 - RSSIZ0
+	LXI	D,-RSSIZ0
+	DAD	D
+	SHLD	UVR+6
+	SHLD	UVR+0AH
 	; initialize SP
-	LHLD	UVR+6
 	SPHL
 	; initialize RP
 	LHLD	UVR+8
 	SHLD	RPP
-	;
+	IF	PROF0
+	; stop PROFILE ( of a saved system )
+	MVI	A,5EH	; "MOV E,M"
+	STA	NEXT1
+	LXI	H,5623H	; "INX H", "MOV D,M"
+	SHLD	NEXT1+1
+	ENDIF
+	; empty the console output ( of a saved system )
+	LXI	H,OBUF
+	SHLD	OPTR
+	; initialize IP
+	LXI	B,CLD1
 	JMP	NEXT
 CLD1	DW	COLD
 ;
@@ -225,9 +295,9 @@ WRM1	DW	WARM
 UVR	DW	0		; (release No.)
 	DW	5		; (revision No.)
 	DW	0B00H		; (user version)
-	DW	INITS0		; S0
-	DW	INITR0		; R0
-	DW	INITS0		; TIB
+	DW	0		; S0  ( set by the cold start )
+	DW	0		; R0  ( set by the cold start )
+	DW	0		; TIB ( set by the cold start )
 	DW	31		; WIDTH
 	DW	0		; WARNING
 	DW	INITDP		; FENCE
@@ -249,6 +319,10 @@ UVR	DW	0		; (release No.)
 	DW	0		; HLD
 UVREND	DW	0		; PFLAG
 ;
+; ***** USER VARIABLES AREA *****
+;
+UP	DS	40H		; user variables area size = 40H
+;
 ; ***** INTERFACE (for CP/M-80) *****
 ;
 ; Function labels in the jump table of CP/M's BIOS
@@ -274,6 +348,7 @@ IOS:	LHLD	BIOST
 ; ( --- f ; Take a type-state of keybord. )
 CTST	DW	$+2
 	PUSH	B
+	CALL	OFLSH
 	LXI	D,CONSTA
 	CALL	IOS
 	POP	B
@@ -285,6 +360,7 @@ CTST	DW	$+2
 ; ( --- c ; Input one character from keybord. )
 CIN	DW	$+2
 	PUSH	B
+	CALL	OFLSH
 	LXI	D,CONIN
 	CALL	IOS
 	POP	B
@@ -292,17 +368,98 @@ CIN	DW	$+2
 	MVI	H,0
 	JMP	HPUSH
 ;
+; The console output is gathered in OBUF, and written out when
+; it is full, at CR, and before the keyboard is read.
+OPTR	DW	OBUF	; the end of the output in OBUF
+OBUF	DS	OBLEN0+1	; ( +1 for the end mark "$" )
+;
+; Put A at the end of OBUF, and write OBUF out when it is full.
+OPUT:	LHLD	OPTR
+	MOV	M,A
+	INX	H
+	SHLD	OPTR
+	LXI	D,-OBUF-OBLEN0
+	DAD	D
+	RNC		; not full
+;
+; Write the output in OBUF to console.
+OFLSH:	LHLD	OPTR
+	LXI	D,-OBUF
+	DAD	D
+	MOV	A,H
+	ORA	L
+	RZ		; no output
+	LHLD	OPTR
+	MVI	M,24H	; the end mark "$"
+	PUSH	H	; save the end
+	LXI	H,OBUF
+	SHLD	OPTR
+OFLSH1:	MOV	D,H
+	MOV	E,L	; DE <- the start of a string
+OFLSH2:	MOV	A,M
+	CPI	24H	; "$"
+	JZ	OFLSH3
+	INX	H
+	JMP	OFLSH2
+OFLSH3:	PUSH	H	; save the "$"
+	MOV	A,L
+	CMP	E
+	JNZ	OFLSH4
+	MOV	A,H
+	CMP	D
+	JZ	OFLSH5	; ( an empty string )
+	; BDOS function 9 (C_WRITESTR)
+OFLSH4:	MVI	C,9	; select "Output string"
+	CALL	0005H	; call BDOS (for using TAB)
+OFLSH5:	POP	H	; HL <- the "$"
+	POP	D	; DE <- the end
+	MOV	A,L
+	CMP	E
+	JNZ	OFLSH6
+	MOV	A,H
+	CMP	D
+	RZ		; the end mark
+OFLSH6:	PUSH	D
+	PUSH	H
+	; BDOS function 2 (C_WRITE) for "$" in the output
+	MVI	E,24H	; "$"
+	MVI	C,2	; select "Console output"
+	CALL	0005H
+	POP	H
+	INX	H
+	JMP	OFLSH1
+;
 ; ( c --- ; Output one character to console. )
 COUT	DW	$+2
-	POP	D
+	POP	H
+	MOV	A,L
 	PUSH	B
-	; BDOS function 2 (C_WRITE)
-	MVI	C,2	; select "Console output"
-	CALL	0005H	; call BDOS (for using TAB)
-	;
+	CALL	OPUT
 	POP	B
 	JMP	NEXT
 ;
+; ( a n --- ; Output n characters from a to console. )
+OTYPE	DW	$+2
+	POP	H	; HL <- n
+	POP	D	; DE <- a
+	PUSH	B	; save IP
+OTYPE1:	MOV	A,H
+	ORA	A
+	JM	OTYPE2	; ( n < 0 )
+	ORA	L
+	JZ	OTYPE2
+	DCX	H
+	LDAX	D
+	INX	D
+	PUSH	H
+	PUSH	D
+	CALL	OPUT
+	POP	D
+	POP	H
+	JMP	OTYPE1
+OTYPE2:	POP	B	; restore IP
+	JMP	NEXT
+;
 ; ( c --- ; Output one character to printer. )
 POUT	DW	$+2
 	POP	D
@@ -314,88 +471,356 @@ POUT	DW	$+2
 	POP	B
 	JMP	NEXT
 ;
-; ( drvNo bufAddr secNo --- errFlg ; Read a sector on disks. )
-READ	DW	$+2
-	POP	D	; truck No.
-	PUSH	B
-	MOV	C,E
-	MOV	B,D
-	LXI	D,SETTRK
-	CALL	IOS
-	POP	B
-	POP	D	; sector No.
-	LXI	H,SOFSET
-	XCHG
+FCB	EQU	005CH	; default FCB
+;
+; ( a --- ; Set the file name of the counted string a
+;           ( [d:]name[.ext], .COM if no ext ) in the default FCB. )
+SETFCB	DW	$+2
+	POP	H	; HL <- a
+	PUSH	B	; save IP
+	MOV	C,M	; C <- length
+	INX	H
+	; clear the FCB
+	LXI	D,FCB
+	XRA	A
+	STAX	D	; ( default drive )
+	MVI	B,11
+	MVI	A,20H	; ( blank )
+SETF1:	INX	D
+	STAX	D
+	DCR	B
+	JNZ	SETF1
+	MVI	B,36-12
+	XRA	A
+SETF2:	INX	D
+	STAX	D
+	DCR	B
+	JNZ	SETF2
+	; drive
+	MOV	A,C
+	CPI	2
+	JC	SETF3
+	INX	H
+	MOV	A,M
+	DCX	H
+	CPI	3AH	; ':'
+	JNZ	SETF3
+	MOV	A,M
+	ANI	1FH	; ( 'A' -> 1, 'B' -> 2, ... )
+	STA	FCB
+	INX	H
+	INX	H
+	DCR	C
+	DCR	C
+	; name
+SETF3:	LXI	D,FCB+1
+	MVI	B,8
+	CALL	SETFN
+	; extension
+	LXI	D,FCB+9
+	MVI	B,3
+	MOV	A,C
+	ORA	A
+	JZ	SETF4
+	INX	H	; ( skip '.' )
+	DCR	C
+	CALL	SETFN
+	POP	B	; restore IP
+	JMP	NEXT
+SETF4:	XCHG
+	MVI	M,43H	; 'C'
+	INX	H
+	MVI	M,4FH	; 'O'
+	INX	H
+	MVI	M,4DH	; 'M'
+	POP	B	; restore IP
+	JMP	NEXT
+;
+; [DE]... <- the C characters from [HL] on up to '.'
+;           ( B characters at most, in uppercase )
+SETFN:	MOV	A,C
+	ORA	A
+	RZ
+	MOV	A,M
+	CPI	2EH	; '.'
+	RZ
+	INX	H
+	DCR	C
+	INR	B
+	DCR	B
+	JZ	SETFN	; ( over the field )
+	CPI	61H	; 'a'
+	JC	SETFN1
+	CPI	7BH	; 'z' + 1
+	JNC	SETFN1
+	SUI	20H
+SETFN1:	STAX	D
+	INX	D
+	DCR	B
+	JMP	SETFN
+;
+; ( a1 a2 --- ef ; Write the memory from a1 to a2 into the file
+;                  of the default FCB, record by record. )
+SAVE	DW	$+2
+	POP	D	; DE <- a2
+	POP	H	; HL <- a1
+	PUSH	B	; save IP
+	PUSH	D
+	PUSH	H
+	MVI	A,0FFH	; ( Select the drive anew. )
+	STA	CDRV
+	; log in the disks again ( the BIOS is called directly )
+	MVI	C,25	; BDOS function 25 (DRV_GET)
+	CALL	0005H
+	PUSH	PSW
+	MVI	C,13	; BDOS function 13 (DRV_ALLRESET)
+	CALL	0005H
+	POP	PSW
+	MOV	E,A
+	MVI	C,14	; BDOS function 14 (DRV_SET)
+	CALL	0005H
+	; make the file anew
+	LXI	D,FCB
+	MVI	C,19	; BDOS function 19 (F_DELETE)
+	CALL	0005H
+	LXI	D,FCB
+	MVI	C,22	; BDOS function 22 (F_MAKE)
+	CALL	0005H
+	INR	A	; ( 0FFH = error )
+	JZ	SAVE3
+	; while a1 < a2, write the record at a1
+SAVE1:	POP	H	; HL <- a1
+	POP	D	; DE <- a2
+	PUSH	D
+	MOV	A,L
+	SUB	E
+	MOV	A,H
+	SBB	D
+	JNC	SAVE2
+	LXI	D,128
+	DAD	D
+	PUSH	H	; ( the next record )
+	LXI	D,-128
 	DAD	D
 	XCHG
-	PUSH	B
-	MOV	C,E
-	MOV	B,D
-	LXI	D,SETSEC
-	CALL	IOS
-	POP	B
-	POP	D	; DMA address
-	PUSH	B
-	MOV	C,E
-	MOV	B,D
-	LXI	D,SETDMA
-	CALL	IOS
-	POP	B
-	POP	D	; drive No.
-	PUSH	B
-	MOV	A,E
-	ADI	DOFSET
-	MOV	C,A
-	LXI	D,SELDSK
-	CALL	IOS
-	LXI	D,READS
-	CALL	IOS
-	POP	B
+	MVI	C,26	; BDOS function 26 (F_DMAOFF)
+	CALL	0005H
+	LXI	D,FCB
+	MVI	C,21	; BDOS function 21 (F_WRITE)
+	CALL	0005H
+	ORA	A
+	JZ	SAVE1
+	JMP	SAVE3	; error
+SAVE2:	PUSH	H
+	LXI	D,FCB
+	MVI	C,16	; BDOS function 16 (F_CLOSE)
+	CALL	0005H
+	INR	A	; ( 0FFH = error )
+	JZ	SAVE3
+	XRA	A
+	JMP	SAVE4
+SAVE3:	MVI	A,1
+SAVE4:	POP	H
+	POP	H
+	PUSH	PSW
+	LXI	D,0080H	; ( the default DMA address )
+	MVI	C,26	; BDOS function 26 (F_DMAOFF)
+	CALL	0005H
+	MVI	A,0FFH	; ( Select the drive anew. )
+	STA	CDRV
+	POP	PSW
+	POP	B	; restore IP
 	MOV	L,A	; A = 0 if no error
 	MVI	H,0
 	JMP	HPUSH
 ;
-; ( drvNo bufAddr secNo --- errFLg ; Write a sector on disks. )
+; ( drvNo bufAddr secNo truckNo --- errFlg ; Read a sector on disks. )
+READ	DW	$+2
+	LXI	H,READS
+	JMP	READ1
+;
+; ( drvNo bufAddr secNo truckNo --- errFLg ; Write a sector on disks. )
 WRITE	DW	$+2
-	POP	D	; truck No.
-	PUSH	B
-	MOV	C,E
-	MOV	B,D
-	LXI	D,SETTRK
+	LXI	H,WRITES
+READ1:	SHLD	DFUNC
+	POP	H	; truck No.
+	SHLD	DTRK
+	POP	H	; sector No.
+	SHLD	DSEC
+	POP	H	; DMA address
+	SHLD	DDMA
+	POP	H	; drive No.
+	SHLD	DDRV
+	LXI	H,1
+	SHLD	DCNT
+	LXI	H,BBUF0
+	JMP	DSKIO
+;
+; count = 0 : drop the other arguments, and return errFlg = 0
+;   without calling BIOS.
+RDREC2:	POP	D
+	POP	D
+	POP	D
+	JMP	HPUSH	; ( HL = 0 )
+;
+; ( drvNo bufAddr blkNo count --- errFlg ;
+;   Read count sectors from the block blkNo on. )
+RDRECS	DW	$+2
+	LXI	H,READS
+	LXI	D,BBUF0
+	JMP	RDREC1
+;
+; ( drvNo bufAddr blkNo count --- errFlg ;
+;   Write count sectors from the block blkNo on. )
+WRRECS	DW	$+2
+	LXI	H,WRITES
+	LXI	D,BBUF0
+	JMP	RDREC1
+;
+; ( drvNo bufAddr blkNo count --- errFlg ;
+;   Read count sectors from the block blkNo on
+;   into the disk buffers from bufAddr on. )
+RDBUFS	DW	$+2
+	LXI	H,READS
+	LXI	D,BFLEN0
+	JMP	RDREC1
+;
+; ( drvNo bufAddr blkNo count --- errFlg ;
+;   Write count sectors from the block blkNo on
+;   out of the disk buffers from bufAddr on. )
+WRBUFS	DW	$+2
+	LXI	H,WRITES
+	LXI	D,BFLEN0
+RDREC1:	SHLD	DFUNC
+	XCHG
+	SHLD	DSTEP
+	POP	H	; count
+	MOV	A,H
+	ORA	L
+	JZ	RDREC2
+	SHLD	DCNT
+	POP	H	; block No.
+	MVI	E,SPT
+	CALL	DIVE
+	SHLD	DTRK	; truck No. = block No. / SPT
+	INR	A	; Note. Sector No. is 1 base.
+	MOV	L,A
+	MVI	H,0
+	SHLD	DSEC
+	POP	H	; DMA address
+	SHLD	DDMA
+	POP	H	; drive No.
+	SHLD	DDRV
+	LHLD	DSTEP
+;
+; Transfer [DCNT] sectors to/from [DDMA], [DDMA]+HL, ... .
+;   SELDSK and SETTRK are called only if the drive or the truck
+;   differs from the last one.
+DSKIO:	SHLD	DSTEP
+	PUSH	B	; save IP
+	; if the drive is changed then select it
+DSKIO1:	LDA	DDRV
+	ADI	DOFSET
+	LXI	H,CDRV
+	CMP	M
+	JZ	DSKIO2
+	MOV	M,A
+	MOV	C,A
+	LXI	D,SELDSK
 	CALL	IOS
-	POP	B
-	POP	D	; sector No.
-	LXI	H,SOFSET
+	LXI	H,0FFFFH
+	SHLD	CTRK	; ( Set the truck anew. )
+	; if the truck is changed then set it
+DSKIO2:	LHLD	DTRK
 	XCHG
+	LHLD	CTRK
+	MOV	A,L
+	CMP	E
+	JNZ	DSKIO3
+	MOV	A,H
+	CMP	D
+	JZ	DSKIO4
+DSKIO3:	XCHG
+	SHLD	CTRK
+	MOV	C,L
+	MOV	B,H
+	LXI	D,SETTRK
+	CALL	IOS
+	; set the sector and the DMA address
+DSKIO4:	LHLD	DSEC
+	LXI	D,SOFSET
 	DAD	D
-	XCHG
-	PUSH	B
-	MOV	C,E
-	MOV	B,D
+	MOV	C,L
+	MOV	B,H
 	LXI	D,SETSEC
 	CALL	IOS
-	POP	B
-	POP	D	; DMA address
-	PUSH	B
-	MOV	C,E
-	MOV	B,D
+	LHLD	DDMA
+	MOV	C,L
+	MOV	B,H
 	LXI	D,SETDMA
 	CALL	IOS
-	POP	B
-	POP	D	; drive No.
-	PUSH	B
-	MOV	A,E
-	ADI	DOFSET
-	MOV	C,A
-	LXI	D,SELDSK
-	CALL	IOS
-	LXI	D,WRITES
+	; read or write
+	MVI	C,1	; ( write type : not deferred )
+	LHLD	DFUNC
+	XCHG
 	CALL	IOS
-	POP	B
+	ORA	A
+	JNZ	DSKIO6	; error
+	; next sector
+	LHLD	DDMA
+	XCHG
+	LHLD	DSTEP
+	DAD	D
+	SHLD	DDMA
+	LHLD	DSEC
+	INX	H
+	SHLD	DSEC
+	MOV	A,L
+	CPI	SPT+1
+	JC	DSKIO5
+	LXI	H,1	; next truck
+	SHLD	DSEC
+	LHLD	DTRK
+	INX	H
+	SHLD	DTRK
+DSKIO5:	LHLD	DCNT
+	DCX	H
+	SHLD	DCNT
+	MOV	A,H
+	ORA	L
+	JNZ	DSKIO1
+DSKIO6:	POP	B	; restore IP
 	MOV	L,A	; A = 0 if no error
 	MVI	H,0
 	JMP	HPUSH
 ;
+; HL <- HL / E, A <- HL mod E ( D broken )
+DIVE:	XRA	A
+; HL <- AHL / E, A <- AHL mod E ( A < E, D broken )
+DIVEA:	MVI	D,16
+DIVE1:	DAD	H
+	RAL
+	JC	DIVE2
+	CMP	E
+	JC	DIVE3
+DIVE2:	SUB	E
+	INX	H
+DIVE3:	DCR	D
+	JNZ	DIVE1
+	RET
+;
+; (parameters of DSKIO)
+DFUNC	DW	0	; READS or WRITES
+DDRV	DW	0	; drive No.
+DDMA	DW	0	; DMA address
+DTRK	DW	0	; truck No.
+DSEC	DW	0	; sector No.
+DCNT	DW	0	; number of sectors
+DSTEP	DW	0	; DMA address step
+; (the drive and the truck selected last)
+CDRV	DB	0FFH	; ( 0FFH = none )
+CTRK	DW	0FFFFH
+;
 ; ***** FORTH INNER INTERPRETER *****
 ;
 ; DPUSH		( --- W HL )
@@ -418,6 +843,20 @@ NEXT1:	MOV	E,M
 	MOV	D,M
 	XCHG
 	PCHL
+;
+	IF	NATIV0
+; NATIV		( --- ; Run the machine code following this cell. )
+;
+; A colon definition compiled in NATIVE mode has its simple
+; primitives, constants, variables and literals laid in line
+; as machine code. The code is entered from the thread by the
+; cell NATIV and goes back to the thread by "LXI B,a / JMP NEXT"
+; (a: the address following the JMP).
+NATIV:	DW	$+2
+	MOV	H,B
+	MOV	L,C
+	PCHL
+	ENDIF
 ;
 ; ***** Word's Structure *****
 ;
@@ -506,69 +945,87 @@ ZBRAN	DW	$+2
 	INX	B
 	JMP	NEXT
 ;
-; ( --- ; [RP]++, jump to [IP] if [RP] < [RP+2]. )
+;
+; The frame of DO ... LOOP on the return stack is the index at [RP]
+; and the index minus the limit at [RP+2], so that I is [RP] and
+; the loop ends when the difference turns non-negative.
+;
+; ( --- ; [RP]++, [RP+2]++, jump to [IP] if [RP+2] < 0. )
 	DB	86H,'(LOOP',')'+80H
 	DW	ZBRAN-10
 XLOOP	DW	$+2
-	LXI	D,1	; increment = 1
-XLOOP1:	LHLD	RPP
-	; [RP+1][RP] <- [RP+1][RP] + DE
-	MOV	A,M
-	ADD	E
-	MOV	M,A
-	INX	H
-	MOV	A,M
-	ADC	D
-	MOV	M,A
-	; A_ <- [RP+1][RP] - [RP+3][RP+2]
-	DCX	H
-	MOV	A,M
-	INX	H
-	INX	H
-	MOV	E,M
-	SUB	E
-	DCX	H
-	MOV	A,M
+	LHLD	RPP
+	INR	M	; index++
 	INX	H
+	JNZ	XLOOP1
+	INR	M
+XLOOP1:	INX	H
+	INR	M	; index - limit ++
 	INX	H
-	MOV	E,M
-	SBB	E
-	;
-	XRA	D
+	JNZ	XLOOP2
+	INR	M
+XLOOP2:	MOV	A,M
+	ORA	A
 	JM	BRAN1
 	;
-	INX	H
+XLOOP3:	INX	H
 	SHLD	RPP
 	INX	B
 	INX	B
 	JMP	NEXT
 ;
-; ( n  --- ; [RP]+=n, jump to [IP] if [RP] < [RP+2]. )
+; ( n  --- ; [RP]+=n, [RP+2]+=n, jump to [IP] if the sign of
+;   [RP+2] differs from that of n. )
 	DB	87H,'(+LOOP',')'+80H
 	DW	XLOOP-9
 XPLOO	DW	$+2
 	POP	D	; increment = n
-	JMP	XLOOP1
+	LHLD	RPP
+	MOV	A,M
+	ADD	E
+	MOV	M,A
+	INX	H
+	MOV	A,M
+	ADC	D
+	MOV	M,A	; index += n
+	INX	H
+	MOV	A,M
+	ADD	E
+	MOV	M,A
+	INX	H
+	MOV	A,M
+	ADC	D
+	MOV	M,A	; index - limit += n
+	;
+	XRA	D
+	JM	BRAN1
+	JMP	XLOOP3
 ;
-; ( n1 n2 --- ; Push n1, n2 to Return Stack. )
+; ( n1 n2 --- ; Push n1 = limit, n2 = index to Return Stack
+;   as n2 - n1 and n2. )
 	DB	84H,'(DO',')'+80H
 	DW	XPLOO-10
 XDO	DW	$+2
+	POP	H	; HL <- index
+	POP	D	; DE <- limit
+	MOV	A,L
+	SUB	E
+	MOV	E,A
+	MOV	A,H
+	SBB	D
+	MOV	D,A	; DE <- index - limit
+	PUSH	H
 	LHLD	RPP
 	DCX	H
+	MOV	M,D
 	DCX	H
-	DCX	H
-	DCX	H
-	SHLD	RPP
-	POP	D
 	MOV	M,E
-	INX	H
+	POP	D	; DE <- index
+	DCX	H
 	MOV	M,D
-	POP	D
-	INX	H
+	DCX	H
 	MOV	M,E
-	INX	H
-	MOV	M,D
+	SHLD	RPP
 	JMP	NEXT
 ;
 ; ( n1 n2 --- n3 ; n3 = n1 & n2 )
@@ -857,10 +1314,27 @@ USTAR	DW	$+2
 	POP	D	; DE <- u2
 	POP	H	; HL <- u1
 	PUSH	B	; save IP
-	; B <- u1H
-	MOV	B,H
-	; AHL <- u1L * u2
-	MOV	A,L	; A <- u1L
+	; if u1H == 0 or u2H == 0 then jump to USTA1
+	MOV	A,H
+	ORA	A
+	JZ	USTA1
+	MOV	A,D
+	ORA	A
+	JNZ	USTA2
+	XCHG
+	; AHL <- u1L * u2 ( u1 < 256 )
+USTA1:	MOV	A,L
+	CALL	XSYY
+	MOV	E,A
+	MVI	D,0
+	POP	B	; restore IP
+	PUSH	H	; push d3L
+	PUSH	D	; push d3H
+	JMP	NEXT
+	; B <- u1H
+USTA2:	MOV	B,H
+	; AHL <- u1L * u2
+	MOV	A,L	; A <- u1L
 	CALL	XSYY	; AHL <- u1L * u2 (#1)
 	; save HL(#1)
 	PUSH	H
@@ -890,7 +1364,14 @@ USTAR	DW	$+2
 ; subroutine XSYY
 ; AHL <- A * DE
 XSYY:	LXI	H,0	; HL <- 0
+	ORA	A
+	RZ		; ( A = 0 )
 	MVI	C,8	; counter = 8
+	; skip the leading zeros of A
+XSYY0:	JM	XSYY1
+	DCR	C
+	ADD	A	; A << 1
+	JMP	XSYY0
 	; AHL << 1
 XSYY1:	DAD	H
 	RAL
@@ -925,10 +1406,76 @@ USLAS	DW	$+2
 	SUB	C
 	MOV	A,H
 	SBB	B
-	JC	USLA1
+	JC	USLA8
 	; u3 = 0xFFFF, u4 = 0xFFFF. (overflow)
 	LXI	H,0FFFFH	; u3
 	LXI	D,0FFFFH	; u4
+	JMP	USLA7
+	; if u2 is a power of 2 then jump to USLA12
+USLA8:	PUSH	H
+	MOV	H,B
+	MOV	L,C
+	DCX	H
+	MOV	A,L
+	ANA	C
+	MOV	L,A
+	MOV	A,H
+	ANA	B
+	ORA	L
+	POP	H
+	JZ	USLA12
+	; if u2 >= 256 then jump to USLA1
+	MOV	A,B
+	ORA	A
+	JNZ	USLA1
+	; u4 <- u3u4 / u2, u3 <- u3u4 mod u2 ( u3 < u2 < 256 )
+	MOV	A,C
+	CPI	10
+	MOV	A,L	; A <- u3
+	JZ	USLA9
+	XCHG
+	MOV	E,C
+	CALL	DIVEA
+	XCHG
+	JMP	USLA10
+USLA9:	CALL	D10
+USLA10:	MOV	L,A
+	MVI	H,0
+	JMP	USLA7
+	; u3 <- u4 & ( u2 - 1 ), u3u4 >> log2( u2 )
+USLA12:	DCX	B
+	PUSH	H
+	MOV	A,E
+	ANA	C
+	MOV	L,A
+	MOV	A,D
+	ANA	B
+	MOV	H,A
+	XTHL		; push u3
+USLA13:	MOV	A,B
+	ORA	C	; ( CY = 0 )
+	JZ	USLA14
+	MOV	A,B
+	RAR
+	MOV	B,A
+	MOV	A,C
+	RAR
+	MOV	C,A
+	MOV	A,H
+	ANA	A	; CY = 0
+	RAR
+	MOV	H,A
+	MOV	A,L
+	RAR
+	MOV	L,A
+	MOV	A,D
+	RAR
+	MOV	D,A
+	MOV	A,E
+	RAR
+	MOV	E,A
+	JMP	USLA13
+USLA14:	POP	H	; HL <- u3
 	JMP	USLA7
 	; counter = 16
 USLA1:	MVI	A,16
@@ -977,6 +1524,82 @@ USLA7:	POP	B	; restore IP
 	PUSH	H	; push u3
 	PUSH	D	; push u4
 	JMP	NEXT
+; subroutine D10
+; DE <- ADE / 10, A <- ADE mod 10 ( A < 10, BC and HL broken )
+D10:	LXI	B,T10
+	ADD	A
+	ADD	A
+	ADD	A
+	ADD	A	; A <- A * 16
+	CALL	D10B	; D <- D / 10
+	MOV	H,D
+	MOV	D,E
+	MOV	E,H
+	CALL	D10B	; D <- E / 10
+	MOV	H,D
+	MOV	D,E
+	MOV	E,H
+	RRC
+	RRC
+	RRC
+	RRC
+	RET
+; subroutine D10B
+; D <- ( A * 16 + D ) / 10, A <- ( ( A * 16 + D ) mod 10 ) * 16
+;   ( A = a remainder * 16, BC = T10 ; HL broken )
+D10B:	MOV	H,A
+	MOV	A,D
+	RRC
+	RRC
+	RRC
+	RRC
+	MOV	D,A	; D <- the nibbles swapped
+	ANI	0FH
+	ORA	H
+	MOV	L,A
+	MVI	H,0
+	DAD	B
+	MOV	A,M	; A <- T10[ rem * 16 + the high nibble ]
+	MOV	H,A
+	XRA	D
+	ANI	0FH
+	XRA	D
+	MOV	D,A	; D <- the low nibble * 16 + the quotient
+	MOV	A,H
+	ANI	0F0H
+	MOV	H,A
+	MOV	A,D
+	RRC
+	RRC
+	RRC
+	RRC
+	MOV	D,A	; D <- the quotient * 16 + the low nibble
+	ANI	0FH
+	ORA	H
+	MOV	L,A
+	MVI	H,0
+	DAD	B
+	MOV	A,M	; A <- T10[ rem * 16 + the low nibble ]
+	MOV	H,A
+	XRA	D
+	ANI	0FH
+	XRA	D
+	MOV	D,A	; D <- the quotient
+	MOV	A,H
+	ANI	0F0H
+	RET
+; T10[ n ] = ( n mod 10 ) * 16 + n / 10  ( n < 160 )
+T10:
+	DB	00H,10H,20H,30H,40H,50H,60H,70H,80H,90H,01H,11H,21H,31H,41H,51H
+	DB	61H,71H,81H,91H,02H,12H,22H,32H,42H,52H,62H,72H,82H,92H,03H,13H
+	DB	23H,33H,43H,53H,63H,73H,83H,93H,04H,14H,24H,34H,44H,54H,64H,74H
+	DB	84H,94H,05H,15H,25H,35H,45H,55H,65H,75H,85H,95H,06H,16H,26H,36H
+	DB	46H,56H,66H,76H,86H,96H,07H,17H,27H,37H,47H,57H,67H,77H,87H,97H
+	DB	08H,18H,28H,38H,48H,58H,68H,78H,88H,98H,09H,19H,29H,39H,49H,59H
+	DB	69H,79H,89H,99H,0AH,1AH,2AH,3AH,4AH,5AH,6AH,7AH,8AH,9AH,0BH,1BH
+	DB	2BH,3BH,4BH,5BH,6BH,7BH,8BH,9BH,0CH,1CH,2CH,3CH,4CH,5CH,6CH,7CH
+	DB	8CH,9CH,0DH,1DH,2DH,3DH,4DH,5DH,6DH,7DH,8DH,9DH,0EH,1EH,2EH,3EH
+	DB	4EH,5EH,6EH,7EH,8EH,9EH,0FH,1FH,2FH,3FH,4FH,5FH,6FH,7FH,8FH,9FH
 ;
 ; ( n1 --- n2 ; n2 = n1 >> 1, arithmetical shift )
 	DB	82H,'2','/'+80H
@@ -1035,6 +1658,20 @@ CSTOR	DW	$+2
 	MOV	M,E
 	JMP	NEXT
 ;
+; subroutine BCD16, BCD8, BCD2
+; BC <- BC / 16, BC / 8, BC / 2 ( A broken )
+BCD16:	CALL	BCD2
+BCD8:	CALL	BCD2
+	CALL	BCD2
+BCD2:	MOV	A,B
+	ORA	A	; CY = 0
+	RAR
+	MOV	B,A
+	MOV	A,C
+	RAR
+	MOV	C,A
+	RET
+;
 ; ( a1 a2 n --- ; n bytes copy )
 ; [a2]=[a1], [a2+1]=[a1+1], ...., [a2+n-1]=[a1+n-1]
 	DB	85H,'CMOV','E'+80H
@@ -1045,16 +1682,61 @@ CMOVEE	DW	$+2
 	POP	B	; BC <- n
 	POP	D	; DE <- a2
 	XTHL		; HL <- a1, stack : IP
+	MOV	A,C
+	ANI	7
+	PUSH	PSW	; save n mod 8
+	CALL	BCD8	; BC <- n / 8
 	JMP	CMOVE2
-CMOVE1:	MOV	A,M	; A <- [HL]
-	STAX	D	; [DE] <- A
-	INX	H	; HL++
-	INX	D	; DE++
+	; copy 8 bytes
+CMOVE1:
+	MOV	A,M
+	STAX	D
+	INX	H
+	INX	D
+	MOV	A,M
+	STAX	D
+	INX	H
+	INX	D
+	MOV	A,M
+	STAX	D
+	INX	H
+	INX	D
+	MOV	A,M
+	STAX	D
+	INX	H
+	INX	D
+	MOV	A,M
+	STAX	D
+	INX	H
+	INX	D
+	MOV	A,M
+	STAX	D
+	INX	H
+	INX	D
+	MOV	A,M
+	STAX	D
+	INX	H
+	INX	D
+	MOV	A,M
+	STAX	D
+	INX	H
+	INX	D
 	DCX	B	; BC--
 CMOVE2:	MOV	A,B
 	ORA	C
 	JNZ	CMOVE1	; if BC <> 0 then goto CMOVE1
-	POP	B	; restore IP
+	; copy the rest
+	POP	PSW
+	ORA	A
+	JZ	CMOVE4
+	MOV	C,A
+CMOVE3:	MOV	A,M	; A <- [HL]
+	STAX	D	; [DE] <- A
+	INX	H	; HL++
+	INX	D	; DE++
+	DCR	C
+	JNZ	CMOVE3
+CMOVE4:	POP	B	; restore IP
 	JMP	NEXT
 ;
 ; ( a1 a2 n --- ; reverse n bytes copy )
@@ -1078,19 +1760,67 @@ LCMOVE	DW	$+2
 	DAD	B	; HL <- HL + BC
 	DCX	H	; HL--
 	;
+	MOV	A,C
+	ANI	7
+	PUSH	PSW	; save n mod 8
+	CALL	BCD8	; BC <- n / 8
 	JMP	LCMOV2
-LCMOV1:	MOV	A,M	; A <- [HL]
-	STAX	D	; [DE] <- A
-	DCX	H	; HL--
-	DCX	D	; DE--
+	; copy 8 bytes
+LCMOV1:
+	MOV	A,M
+	STAX	D
+	DCX	H
+	DCX	D
+	MOV	A,M
+	STAX	D
+	DCX	H
+	DCX	D
+	MOV	A,M
+	STAX	D
+	DCX	H
+	DCX	D
+	MOV	A,M
+	STAX	D
+	DCX	H
+	DCX	D
+	MOV	A,M
+	STAX	D
+	DCX	H
+	DCX	D
+	MOV	A,M
+	STAX	D
+	DCX	H
+	DCX	D
+	MOV	A,M
+	STAX	D
+	DCX	H
+	DCX	D
+	MOV	A,M
+	STAX	D
+	DCX	H
+	DCX	D
 	DCX	B	; BC--
 LCMOV2:	MOV	A,B
 	ORA	C
 	JNZ	LCMOV1	; if BC <> 0 then goto LCMOVE1
-	POP	B	; restore IP
+	; copy the rest
+	POP	PSW
+	ORA	A
+	JZ	LCMOV4
+	MOV	C,A
+LCMOV3:	MOV	A,M	; A <- [HL]
+	STAX	D	; [DE] <- A
+	DCX	H	; HL--
+	DCX	D	; DE--
+	DCR	C
+	JNZ	LCMOV3
+LCMOV4:	POP	B	; restore IP
 	JMP	NEXT
 ;
 ; ( a n b --- ; Fill the n bytes on or after a with b. )
+;   128 bytes or more are filled by pushes from the end, but the
+;   first 64 to 79 bytes. An interrupt during the pushes uses the
+;   bytes under SP, which are filled afterwards.
 	DB	84H,'FIL','L'+80H
 	DW	LCMOVE-9
 FILL	DW	$+2
@@ -1099,23 +1829,117 @@ FILL	DW	$+2
 	POP	D	; DE <- b
 	POP	B	; BC <- n
 	XTHL		; HL <- a, stack : IP
-	XCHG		; DE = a, HL = b
-FILL1:	MOV	A,B
-	ORA	C
-	JZ	FILL2	; if BC == 0 then goto FILL1
-	MOV	A,L	; A <- L
-	STAX	D	; [DE] <- A
-	INX	D	; DE++
+	MOV	D,E	; D = E = b
+	; if n >= 128 then jump to FILL5
+	MOV	A,B
+	ORA	A
+	JNZ	FILL5
+	MOV	A,C
+	CPI	128
+	JNC	FILL5
+	; fill BC bytes on or after HL with E
+FILL1:	MOV	A,C
+	ANI	7
+	PUSH	PSW	; save n mod 8
+	CALL	BCD8	; BC <- n / 8
+	JMP	FILL3
+	; fill 8 bytes
+FILL2:
+	MOV	M,E
+	INX	H
+	MOV	M,E
+	INX	H
+	MOV	M,E
+	INX	H
+	MOV	M,E
+	INX	H
+	MOV	M,E
+	INX	H
+	MOV	M,E
+	INX	H
+	MOV	M,E
+	INX	H
+	MOV	M,E
+	INX	H
 	DCX	B	; BC--
-	JMP	FILL1	; goto FILL1
-FILL2:	POP	B	; restore IP
+FILL3:	MOV	A,B
+	ORA	C
+	JNZ	FILL2	; if BC <> 0 then goto FILL2
+	; fill the rest
+	POP	PSW
+	ORA	A
+	JZ	FILL4
+FILL9:	MOV	M,E
+	INX	H
+	DCR	A
+	JNZ	FILL9
+FILL4:	POP	B	; restore IP
 	JMP	NEXT
+	; fill by pushes
+FILL5:	PUSH	H	; save a
+	DAD	B
+	PUSH	H	; save a + n
+	MOV	A,C	; BC <- n - 64
+	SUI	64
+	MOV	C,A
+	MOV	A,B
+	SBI	0
+	MOV	B,A
+	MOV	A,C
+	ANI	0FH
+	ADI	64
+	MOV	L,A	; L <- the rest ( 64 to 79 bytes )
+	CALL	BCD16	; BC <- the blocks of 16 bytes
+	MOV	A,L
+	POP	H	; HL <- a + n
+	PUSH	PSW	; save the rest
+	PUSH	H
+	LXI	H,0
+	DAD	SP
+	SHLD	FILSP	; save SP
+	POP	H
+	SPHL		; SP <- a + n
+	JMP	FILL7
+	; fill 16 bytes
+FILL6:
+	PUSH	D
+	PUSH	D
+	PUSH	D
+	PUSH	D
+	PUSH	D
+	PUSH	D
+	PUSH	D
+	PUSH	D
+	DCX	B	; BC--
+FILL7:	MOV	A,B
+	ORA	C
+	JNZ	FILL6	; if BC <> 0 then goto FILL6
+	LHLD	FILSP
+	SPHL		; restore SP
+	POP	H
+	POP	PSW
+	MOV	C,A
+	MVI	B,0	; BC <- the rest
+	POP	H	; HL <- a
+	JMP	FILL1
+;
+FILSP	DW	0	; SP saved by FILL
 ;
 ; ( --- ) <name>
 	DB	0C1H,':'+80H
 	DW	FILL-7
 COLON	DW	DOCOL
 	DW	QEXEC
+	IF	NATIV0
+	DW	ZERO
+	DW	LIT,NREG
+	DW	STORE
+	ENDIF
+	IF	FUSE0
+	DW	ZERO
+	DW	LIT,LASTC
+	DW	STORE
+	ENDIF
 	DW	SCSP
 	DW	CURR
 	DW	ATT
@@ -1262,7 +2086,22 @@ COLD	DW	DOCOL
 	DW	UPP		; UP ( constant )
 	DW	LIT,UVREND-UVR+2
 	DW	CMOVEE
+	IF	HASHED
+	DW	LIT,UVR+12H	; initial DP
+	DW	ATT
+	DW	LIT,INITDP
+	DW	EQUAL
+	DW	ZBRAN,COLD1-$	; IF
+	DW	HBUILD		;  ( the kernel only )
+	DW	BRAN,COLD2-$	; ELSE
+COLD1	DW	TRIM		;  ( a saved system )
+				; THEN
+COLD2	DW	EMPBUF
+	ENDIF
+	IF	NOT HASHED
+	DW	TRIM
 	DW	EMPBUF
+	ENDIF
 	DW	ABORT
 ;
 ; ( --- )
@@ -1301,20 +2140,25 @@ EMIT1	DW	DROP
 				; THEN
 EMIT2	DW	SEMIS
 ;
+; ( --- ; Write the console output gathered out. )
+	DB	8BH,'(FLUSH-OUT',')'+80H
+	DW	EMIT-7
+OFLUS	DW	$+2
+	PUSH	B
+	CALL	OFLSH
+	POP	B
+	JMP	NEXT
+;
 ; ( n1 a n2 --- ef ; 1 block only )
 ; n1: drive number
 ; a : address of disk buffer
 ; n2: reading block
 ; ef: error flag
 	DB	88H,'READ-RE','C'+80H
-	DW	EMIT-7
+	DW	OFLUS-14
 RREC	DW	DOCOL
-	DW	LIT,SPT
-	DW	SLMOD		; n1 a n2 n3
-	DW	SWAP
-	DW	ONEP		; Note. Sector No. is 1 base.
-	DW	SWAP
-	DW	READ
+	DW	ONE
+	DW	RDRECS
 	DW	SEMIS
 ;
 ; ( n1 a n2 --- ef ; 1 block only )
@@ -1325,12 +2169,32 @@ RREC	DW	DOCOL
 	DB	89H,'WRITE-RE','C'+80H
 	DW	RREC-11
 WREC	DW	DOCOL
-	DW	LIT,SPT
-	DW	SLMOD
-	DW	SWAP
-	DW	ONEP		; Note. Sector No. is 1 base.
-	DW	SWAP
-	DW	WRITE
+	DW	ONE
+	DW	WRRECS
+	DW	SEMIS
+;
+; ( n1 a n2 n3 --- ef )
+; n1: drive number
+; a : address of disk buffer ( n3 * 128 bytes )
+; n2: first reading block
+; n3: number of blocks
+; ef: error flag
+	DB	89H,'READ-REC','S'+80H
+	DW	WREC-12
+RRECS	DW	DOCOL
+	DW	RDRECS
+	DW	SEMIS
+;
+; ( n1 a n2 n3 --- ef )
+; n1: drive number
+; a : address of disk buffer ( n3 * 128 bytes )
+; n2: first writing block
+; n3: number of blocks
+; ef: error flag
+	DB	8AH,'WRITE-REC','S'+80H
+	DW	RRECS-12
+WRECS	DW	DOCOL
+	DW	WRRECS
 	DW	SEMIS
 ;
 ; 	===== constants =====
@@ -1338,7 +2202,7 @@ WREC	DW	DOCOL
 ; ( --- n )
 ; (origin)
 	DB	84H,'ORI','G'+80H
-	DW	WREC-12
+	DW	WRECS-13
 ORIGI	DW	DOCON
 	DW	ORIG0
 ;
@@ -1367,13 +2231,13 @@ BFLEN	DW	DOCON
 	DB	85H,'LIMI','T'+80H
 	DW	BFLEN-8
 LIMIT	DW	DOCON
-	DW	LIMIT0
+	DW	LIMIT0		; ( set by the cold start )
 ;
 ; ( --- n )
 	DB	85H,'FIRS','T'+80H
 	DW	LIMIT-8
 FIRST	DW	DOCON
-	DW	FIRST0
+	DW	0		; ( set by the cold start )
 ;
 ; ( --- n )
 	DB	82H,'U','P'+80H
@@ -1444,7 +2308,7 @@ MSGSCR	DW	DOCON
 	DB	85H,'#BUF','F'+80H
 	DW	MSGSCR-9
 NUMBUF	DW	DOCON
-	DW	NUMBU0
+	DW	NUMBU0		; ( set by the cold start )
 ;
 ; 	===== "unofficial" constants =====
 ;
@@ -1468,14 +2332,17 @@ TUVR	DW	DOCON
 	DB	83H,'US','E'+80H
 	DW	TUVR-6
 USE	DW	DOVAR
-	DW	FIRST0
+	DW	0		; ( set by the cold start )
 ;
 ; ( --- a )
 ; (previous)
 	DB	84H,'PRE','V'+80H
 	DW	USE-6
 PREV	DW	DOVAR
-	DW	FIRST0
+	DW	0		; ( set by the cold start )
+;
+; (block hash table)
+BHTAB	DS	BHASH0*2
 ;
 ; ( --- a )
 	DB	8AH,'DISK-ERRO','R'+80H
@@ -1706,6 +2573,75 @@ ENCL3:	MVI	D,0
 	PUSH	D	; push n3 (= counter + 1)
 	JMP	NEXT
 ;
+; ( a c --- n )
+; a : start address in text data
+; c : delimiter code
+; n : offset to the first character not included
+; Lay the text delimited by c at HERE as a counted string,
+; followed by blanks up to HERE+MXTOKN+1, in one pass.
+; (The same token as ENCLOSE and CMOVE in WORD)
+	DB	86H,'(WORD',')'+80H
+	DW	ENCL-10
+WORDP	DW	$+2
+	POP	D	; E <- delimiter
+	POP	H	; HL <- address
+	PUSH	B	; save IP
+	PUSH	H	; save address
+	MOV	C,E	; C <- delimiter
+	MOV	A,E
+	; skip the delimiters
+WORD1:	CMP	M
+	JNZ	WORD2
+	INX	H
+	JMP	WORD1
+WORD2:	XCHG		; DE <- the first character
+	LHLD	UP+12H	; HL <- HERE
+	PUSH	H	; save HERE
+	MVI	B,0	; B <- length
+	; case 1 : null start ( the null is a token of length 1 )
+	LDAX	D
+	ORA	A
+	JNZ	WORD3
+	INX	H
+	MOV	M,A
+	INR	B
+	JMP	WORD5
+	; copy the text
+WORD3:	INX	H
+	MOV	M,A
+	INR	B
+	INX	D
+	LDAX	D
+	; case 3 : text-delimiter end
+	CMP	C
+	JZ	WORD4
+	; case 2 : text-null end
+	ORA	A
+	JNZ	WORD3
+	JMP	WORD5
+WORD4:	INX	D	; ( skip the delimiter )
+	; blank the rest
+WORD5:	MOV	A,B
+	CPI	MXTOKN+1
+	JNC	WORD7
+	MVI	A,MXTOKN+1
+	SUB	B
+WORD6:	INX	H
+	MVI	M,20H	; ( blank )
+	DCR	A
+	JNZ	WORD6
+WORD7:	POP	H	; HL <- HERE
+	MOV	M,B	; lay the length
+	POP	H	; HL <- address
+	MOV	A,E
+	SUB	L
+	MOV	L,A
+	MOV	A,D
+	SBB	H
+	MOV	H,A	; HL <- DE - address
+	POP	B	; restore IP
+	JMP	HPUSH
+;
 ; ( a1 a2 --- a / ff ;
 ;             Search a FORCE WORD in the FORTH DICTONARY. )
 ; a1: top address of text string searched
@@ -1713,7 +2649,7 @@ ENCL3:	MVI	D,0
 ; a : CFA of the found word
 ; ff: false flag
 	DB	86H,'(FIND',')'+80H
-	DW	ENCL-10
+	DW	WORDP-9
 PFIND	DW	$+2
 	POP	D	; DE <- a2
 PFIND1:	POP	H	; HL <- a1
@@ -1761,18 +2697,333 @@ PFIND5:	INX	D	; DE <- LFA
 	LXI	H,0	; false
 	JMP	HPUSH
 ;
-; ( c n1 --- n2 tf / ff )
-; c : character code
-; n1: base value
-; n2: number n2 whom c means in base n1
-; tf: true flag
+	IF	HASHED
+;
+; ***** Hashed Dictionary Index *****
+;
+; Every vocabulary has NHASH0 buckets after its VOC-LINK field.
+;   a   : latest word ( CONTEXT @ , CURRENT @ )
+;   a+2 : VOC-LINK
+;   a+4 : parent vocabulary ( 0 = none )
+;   a+6 : last NFA visible in the parent
+;   a+8 : buckets ( NHASH0 cells )
+; A bucket chains nodes, the newest first.
+;   node   : next node ( 0 = end )
+;   node+2 : NFA
+; The node of a word is laid just before its Name Field
+; ( the kernel words are indexed by COLD at INITDP ).
+;
+; A <- offset of the bucket of the name at HL (HL & E broken)
+;   bucket No. = ( 3 * 1st character + length ) & ( NHASH0 - 1 )
+HASH:	MOV	A,M
+	ANI	1FH	; length
+	MOV	E,A
+	INX	H
+	MOV	A,M
+	ANI	7FH	; 1st character
+	MOV	L,A
+	ADD	A
+	ADD	L
+	ADD	E
+	ADD	A	; A <- bucket No. * 2
+	ANI	NHASH0*2-2
+	RET
+;
+; ( a1 a2 --- a / ff ;
+;             Search a FORCE WORD by the index. )
+; a1: top address of text string searched
+; a2: vocabulary ( CONTEXT @ , CURRENT @ )
+; a : CFA of the found word
 ; ff: false flag
-	DB	85H,'DIGI','T'+80H
+	DB	87H,'(HFIND',')'+80H
 	DW	PFIND-9
-DIGIT	DW	$+2
-	POP	H	; HL <- n1
-	POP	D	; E <- c
-	; if c < '0' then jump to DIGIT2
+HFIND	DW	$+2
+	POP	D	; DE <- a2
+	POP	H	; HL <- a1
+	PUSH	B	; save IP
+	PUSH	H	; save a1
+	PUSH	D
+	CALL	HASH
+	POP	D
+	MOV	C,A
+	MVI	B,0	; BC <- bucket offset
+	LXI	H,0FFFFH	; HL <- limit ( = none )
+	; search the vocabulary DE
+HFIND1:	PUSH	H	; save limit
+	PUSH	D	; save vocabulary
+	LXI	H,8
+	DAD	D
+	DAD	B	; HL <- bucket address
+	; HL <- [HL] ( = next node )
+HFIND2:	MOV	A,M
+	INX	H
+	MOV	H,M
+	MOV	L,A
+	; if HL == 0 then jump to HFIND5
+	ORA	H
+	JZ	HFIND5	; end of bucket
+	PUSH	H	; save node
+	INX	H
+	INX	H
+	MOV	E,M
+	INX	H
+	MOV	D,M	; DE <- NFA
+	; if limit < NFA then jump to HFIND4
+	LXI	H,4
+	DAD	SP	; HL <- address of limit
+	MOV	A,M
+	SUB	E
+	INX	H
+	MOV	A,M
+	SBB	D
+	JC	HFIND4
+	; HL <- a1
+	INX	H
+	MOV	A,M
+	INX	H
+	MOV	H,M
+	MOV	L,A
+	; if ([DE] ^ [HL]) & 3FH <> 0 then jump to HFIND4
+	LDAX	D
+	XRA	M
+	ANI	3FH	; A & 00111111 (smudge bit & length)
+	JNZ	HFIND4
+	; HL++, A <- [++DE]
+HFIND3:	INX	H
+	INX	D
+	LDAX	D
+	; if (A ^ M) + A <> 0 then jump to HFIND4
+	XRA	M
+	ADD	A
+	JNZ	HFIND4	; no match
+	; if CY == 0 then jump to HFIND3
+	JNC	HFIND3	; A & 80H <> 0
+	; case 1 : string matches
+	LXI	H,3
+	DAD	D	; HL <- CFA
+	POP	D	; drop node
+	POP	D	; drop vocabulary
+	POP	D	; drop limit
+	POP	D	; drop a1
+	POP	B	; restore IP
+	JMP	HPUSH
+	; next node
+HFIND4:	POP	H	; HL <- node
+	JMP	HFIND2
+	; search the parent vocabulary
+HFIND5:	POP	H	; HL <- vocabulary
+	POP	D	; drop limit
+	INX	H
+	INX	H
+	INX	H
+	INX	H
+	MOV	E,M
+	INX	H
+	MOV	D,M	; DE <- parent vocabulary
+	INX	H
+	MOV	A,M
+	INX	H
+	MOV	H,M
+	MOV	L,A	; HL <- limit
+	; if DE <> 0 then goto HFIND1
+	MOV	A,D
+	ORA	E
+	JNZ	HFIND1
+	; case 2 : not find
+	POP	H	; drop a1
+	POP	B	; restore IP
+	LXI	H,0	; false
+	JMP	HPUSH
+;
+; ( nfa a --- ; Link the word nfa into the index of
+;               the vocabulary a with a node at HERE. )
+	DB	87H,'(HLINK',')'+80H
+	DW	HFIND-10
+HLINK	DW	$+2
+	POP	D	; DE <- a
+	POP	H	; HL <- nfa
+	PUSH	B	; save IP
+	PUSH	H	; save nfa
+	PUSH	D
+	CALL	HASH
+	POP	H
+	LXI	D,8
+	DAD	D
+	MOV	E,A
+	MVI	D,0
+	DAD	D
+	XCHG		; DE <- bucket address
+	LHLD	UP+12H	; HL <- node ( = DP )
+	; [node+1][node] <- [bucket+1][bucket]
+	LDAX	D
+	MOV	M,A
+	INX	D
+	INX	H
+	LDAX	D
+	MOV	M,A
+	; [node+3][node+2] <- nfa
+	INX	H
+	POP	B	; BC <- nfa
+	MOV	M,C
+	INX	H
+	MOV	M,B
+	; [bucket+1][bucket] <- node
+	DCX	H
+	DCX	H
+	DCX	H
+	XCHG		; DE <- node, HL <- bucket address + 1
+	MOV	M,D
+	DCX	H
+	MOV	M,E
+	POP	B	; restore IP
+	JMP	NEXT
+;
+; ( --- ; Unlink the forgotten words and vocabularies
+;         ( above HERE ) from the index. )
+	DB	88H,'(HPRUNE',')'+80H
+	DW	HLINK-10
+HPRUNE	DW	DOCOL
+				; BEGIN
+HPRUN1	DW	VOCL
+	DW	ATT
+	DW	HERE
+	DW	ULESS
+	DW	ZEQU
+	DW	ZBRAN,HPRUN2-$	; WHILE
+	DW	VOCL
+	DW	ATT
+	DW	ATT
+	DW	VOCL
+	DW	STORE
+	DW	BRAN,HPRUN1-$	; REPEAT
+HPRUN2	DW	VOCL
+	DW	ATT
+				; BEGIN
+HPRUN3	DW	QDUP
+	DW	ZBRAN,HPRUN4-$	; WHILE
+	DW	DUPE
+	DW	LIT,6
+	DW	PLUS		; bucket address
+	DW	LIT,NHASH0
+	DW	ZERO
+	DW	XDO		;  DO
+				;   BEGIN
+HPRUN5	DW	DUPE
+	DW	ATT
+	DW	DUPE
+	DW	HERE
+	DW	ULESS
+	DW	ZEQU
+	DW	ZBRAN,HPRUN6-$	;   WHILE
+	DW	ATT
+	DW	OVER
+	DW	STORE
+	DW	BRAN,HPRUN5-$	;   REPEAT
+HPRUN6	DW	DROP
+	DW	TWOP
+	DW	XLOOP,HPRUN5-$	;  LOOP
+	DW	DROP
+	DW	ATT
+	DW	BRAN,HPRUN3-$	; REPEAT
+HPRUN4	DW	SEMIS
+;
+; ( --- ; Forget the words not of the kernel and
+;         index the kernel words at HERE. )
+	DB	88H,'(HBUILD',')'+80H
+	DW	HPRUNE-11
+HBUILD	DW	$+2
+	PUSH	B	; save IP
+	LXI	H,STAN79-14
+	SHLD	FORTH+4	; latest words <- the kernel's
+	SHLD	ASSEM+4
+	; erase the buckets of FORTH and ASSEMBLER
+	XRA	A
+	LXI	H,FORTH+12
+	MVI	C,NHASH0*2
+HBILD1:	MOV	M,A
+	INX	H
+	DCR	C
+	JNZ	HBILD1
+	LXI	H,ASSEM+12
+	MVI	C,NHASH0*2
+HBILD2:	MOV	M,A
+	INX	H
+	DCR	C
+	JNZ	HBILD2
+	; push the NFAs of the kernel words, the newest first
+	LXI	H,0
+	PUSH	H	; end mark
+	LXI	H,STAN79-14
+HBILD3:	PUSH	H	; save NFA
+	INX	H
+	; HL <- LFA ( next to the last character )
+HBILD4:	MOV	A,M
+	INX	H
+	ORA	A
+	JP	HBILD4
+	MOV	A,M
+	INX	H
+	MOV	H,M
+	MOV	L,A	; HL <- [LFA]
+	ORA	H
+	JNZ	HBILD3
+	; link them into FORTH, the oldest first
+HBILD5:	POP	H	; HL <- NFA
+	MOV	A,H
+	ORA	L
+	JZ	HBILD6	; end mark
+	MOV	B,H
+	MOV	C,L	; BC <- NFA
+	CALL	HASH
+	LXI	H,FORTH+12
+	MOV	E,A
+	MVI	D,0
+	DAD	D
+	XCHG		; DE <- bucket address
+	LHLD	UP+12H	; HL <- node ( = DP )
+	PUSH	H
+	; [node+1][node] <- [bucket+1][bucket]
+	LDAX	D
+	MOV	M,A
+	INX	D
+	INX	H
+	LDAX	D
+	MOV	M,A
+	; [node+3][node+2] <- NFA
+	INX	H
+	MOV	M,C
+	INX	H
+	MOV	M,B
+	INX	H
+	SHLD	UP+12H	; DP <- node + 4
+	; [bucket+1][bucket] <- node
+	POP	H
+	XCHG		; DE <- node, HL <- bucket address + 1
+	MOV	M,D
+	DCX	H
+	MOV	M,E
+	JMP	HBILD5
+HBILD6:	POP	B	; restore IP
+	JMP	NEXT
+;
+DIGITL	EQU	HBUILD-11
+	ENDIF
+	IF	NOT HASHED
+DIGITL	EQU	PFIND-9
+	ENDIF
+;
+; ( c n1 --- n2 tf / ff )
+; c : character code
+; n1: base value
+; n2: number n2 whom c means in base n1
+; tf: true flag
+; ff: false flag
+	DB	85H,'DIGI','T'+80H
+	DW	DIGITL
+DIGIT	DW	$+2
+	POP	H	; HL <- n1
+	POP	D	; E <- c
+	; if c < '0' then jump to DIGIT2
 	MOV	A,E
 	SUI	30H
 	JM	DIGIT2
@@ -2304,20 +3555,26 @@ COUNT	DW	DOCOL
 	DB	84H,'TYP','E'+80H
 	DW	COUNT-8
 TYPES	DW	DOCOL
+	DW	PFLAG		; print flag
+	DW	ATT
+	DW	ZBRAN,TYPES4-$	; IF
 	DW	QDUP
-	DW	ZBRAN,TYPES1-$	; IF
+	DW	ZBRAN,TYPES1-$	;  IF
 	DW	OVER
 	DW	PLUS
 	DW	SWAP
-	DW	XDO		;  DO
+	DW	XDO		;   DO
 TYPES3	DW	IDO
 	DW	CAT
 	DW	EMIT
-	DW	XLOOP,TYPES3-$	;  LOOP
-	DW	BRAN,TYPES2-$	; ELSE
+	DW	XLOOP,TYPES3-$	;   LOOP
+	DW	BRAN,TYPES2-$	;  ELSE
 TYPES1	DW	DROP
+				;  THEN
+TYPES2	DW	BRAN,TYPES5-$	; ELSE
+TYPES4	DW	OTYPE		;  ( the whole string at once )
 				; THEN
-TYPES2	DW	SEMIS
+TYPES5	DW	SEMIS
 ;
 ; ( --- )
 	DB	82H,'C','R'+80H
@@ -2327,6 +3584,7 @@ CR	DW	DOCOL
 	DW	EMIT
 	DW	LIT,0AH		; ( LF code )
 	DW	EMIT
+	DW	OFLUS
 	DW	SEMIS
 ;
 ; ( --- )
@@ -2492,8 +3750,10 @@ PLINE	DW	DOCOL
 	DW	BSCR
 	DW	STAR
 	DW	PLUS
-	DW	BLOCK
+	DW	OFSET
+	DW	ATT
 	DW	PLUS
+	DW	PIN		; ( in the screen cache )
 	DW	CSLL
 	DW	SEMIS
 ;
@@ -2546,10 +3806,46 @@ QSTAC	DW	DOCOL
 	DW	LIT,7H
 	DW	QERR
 	DW	SEMIS
+;
+	IF	QSTK0
+;
+; ( --- ; Check the stack as ?STACK does. ?STACK is called
+;   only when it is out of the range, to report the error. )
+	DB	88H,'(?STACK',')'+80H
+	DW	QSTAC-9
+PQSTK	DW	$+2
+	LXI	H,0
+	DAD	SP	; HL <- SP
+	XCHG
+	LHLD	UP+06H	; HL <- S0
+	MOV	A,L
+	SUB	E
+	MOV	A,H
+	SBB	D
+	JC	PQSTK1	; S0 < SP
+	LHLD	UP+12H	; HL <- HERE
+	LXI	D,TMPBSZ
+	DAD	D
+	XCHG		; DE <- HERE + TMPBSZ
+	LXI	H,0
+	DAD	SP	; HL <- SP
+	MOV	A,L
+	SUB	E
+	MOV	A,H
+	SBB	D
+	JNC	NEXT	; HERE + TMPBSZ <= SP
+PQSTK1:	LXI	H,QSTAC
+	JMP	NEXT1	; execute ?STACK
+;
+QPAIRL	EQU	PQSTK-11
+	ENDIF
+	IF	NOT QSTK0
+QPAIRL	EQU	QSTAC-9
+	ENDIF
 ;
 ; ( n1 n2 --- )
 	DB	86H,'?PAIR','S'+80H
-	DW	QSTAC-9
+	DW	QPAIRL
 QPAIR	DW	DOCOL
 	DW	EQUAL
 	DW	NOTT
@@ -2589,72 +3885,705 @@ SCSP	DW	DOCOL
 	DW	STORE
 	DW	SEMIS
 ;
-; ( --- ) <word>
-	DB	87H,'COMPIL','E'+80H
-	DW	SCSP-7
-COMP	DW	DOCOL
-	DW	QCOMP
-	DW	FROMR
-	DW	DUPE
-	DW	TWOP
-	DW	TOR
-	DW	ATT
-	DW	COMMA
-	DW	SEMIS
+	IF	NATIV0 OR FUSE0
 ;
-; ( --- ) <word>
-	DB	0C9H,'[COMPILE',']'+80H
-	DW	COMP-10
-BCOMP	DW	DOCOL
-	DW	FIND
-	DW	QDUP
-	DW	ZEQU
-	DW	ZERO
-	DW	QERR
-	DW	COMMA
-	DW	SEMIS
+; Z flag <- ( HL == DE )
+CPHD:	MOV	A,H
+	CMP	D
+	RNZ
+	MOV	A,L
+	CMP	E
+	RET
+	ENDIF
 ;
-; ( n --- )
-	DB	0C7H,'LITERA','L'+80H
-	DW	BCOMP-12
-LITER	DW	DOCOL
-	DW	STATE
-	DW	ATT
-	DW	ZBRAN,LITER1-$	; IF
-	DW	COMP
-	DW	LIT
-	DW	COMMA
-				; THEN
-LITER1	DW	SEMIS
+	IF	NATIV0
 ;
-; ( d --- )
-	DB	0C8H,'DLITERA','L'+80H
-	DW	LITER-10
-DLITE	DW	DOCOL
-	DW	STATE
-	DW	ATT
-	DW	ZBRAN,DLITE1-$	; IF
-	DW	SWAP
-	DW	LITER		;  [COMPILE] LITERAL
-	DW	LITER		;  [COMPILE] LITERAL
-				; THEN
-DLITE1	DW	SEMIS
+; ( --- a ; a: NATIVE mode flag )
+;   When it is not 0, the colon definitions are compiled
+;   with the machine code in line.
+	DB	86H,'NATIV','E'+80H
+	DW	SCSP-7
+NATV	DW	DOVAR
+	DW	0
+NREG	DW	0	; ( not 0 : laying the machine code )
+NPUSH	DW	0	; the pushes laid last ( from NPUSH to HERE )
+NSTRT	DW	0	; the start of the machine code being laid
+;
+; Lay the cell NATIV at HERE unless the machine code is being laid.
+; ( HL <- HERE )
+NOPEN:	LHLD	UP+12H	; HL <- HERE
+	LDA	NREG
+	ORA	A
+	RNZ
+	INR	A
+	STA	NREG
+	PUSH	D
+	LXI	D,NATIV
+	MOV	M,E
+	INX	H
+	MOV	M,D
+	INX	H
+	POP	D
+	SHLD	NPUSH	; ( no push )
+	SHLD	NSTRT
+	RET
 ;
-; ( --- )
-	DB	8BH,'DEFINITION','S'+80H
-	DW	DLITE-11
-DEFIN	DW	DOCOL
-	DW	CONT
-	DW	ATT
-	DW	CURR
-	DW	STORE
-	DW	SEMIS
+; Lay "B, E, D, PUSH H" as the machine code.
+;   ( B = "LXI H" or "LHLD", DE = the operand )
+NLAY:	CALL	NOPEN
+	MOV	M,B
+	INX	H
+	MOV	M,E
+	INX	H
+	MOV	M,D
+	INX	H
+	SHLD	NPUSH
+	MVI	M,0E5H	; "PUSH H"
+	INX	H
+	SHLD	UP+12H	; DP <- HL
+	RET
 ;
-; ( n --- )
-	DB	85H,'ALLO','T'+80H
-	DW	DEFIN-14
-ALLOT	DW	DOCOL
-	DW	DP
+; The primitives to lay in line. Each code has no jump but the
+; last "JMP NEXT", "JMP HPUSH" or "JMP DPUSH".
+NTAB:	DW	DUPE
+	DW	DROP
+	DW	SWAP
+	DW	OVER
+	DW	ROT
+	DW	PLUS
+	DW	SUBB
+	DW	DPLUS
+	DW	ANDD
+	DW	ORR
+	DW	XORR
+	DW	ONEP
+	DW	TWOP
+	DW	ONEM
+	DW	TWOM
+	DW	TDIV
+	DW	ATT
+	DW	STORE
+	DW	CAT
+	DW	CSTOR
+	DW	TAT
+	DW	TOGGL
+	DW	TOR
+	DW	FROMR
+	DW	RAT
+	DW	IDO
+	DW	JDO
+	DW	LLEAVE
+	DW	SPAT
+	DW	RPAT
+	DW	0	; end of the table
+;
+; ( --- ; End the machine code being laid at HERE, if any. )
+	DB	88H,'(THREAD',')'+80H
+	DW	NATV-9
+NTHR	DW	$+2
+	LDA	NREG
+	ORA	A
+	JZ	NEXT
+	XRA	A
+	STA	NREG
+	LHLD	UP+12H	; HL <- HERE
+	MVI	M,01H	; "LXI B,HERE+6"
+	INX	H
+	LXI	D,5
+	XCHG
+	DAD	D
+	XCHG
+	MOV	M,E
+	INX	H
+	MOV	M,D
+	INX	H
+	MVI	M,0C3H	; "JMP NEXT"
+	INX	H
+	LXI	D,NEXT
+	MOV	M,E
+	INX	H
+	MOV	M,D
+	INX	H
+	SHLD	UP+12H	; DP <- HL
+	JMP	NEXT
+;
+; ( n --- ; Lay "LXI H,n / PUSH H" at HERE. )
+	DB	86H,'(NLIT',')'+80H
+	DW	NTHR-11
+NLIT	DW	$+2
+	POP	D
+	PUSH	B	; save IP
+	MVI	B,21H	; "LXI H,n"
+	CALL	NLAY
+	POP	B	; restore IP
+	JMP	NEXT
+;
+; The step of LOOP laid in line by (NLOOP). The addresses of
+; the jumps in the loop are relative to NLPT, and the address of
+; "JM" is the start of the loop body.
+NLPT:	LHLD	RPP
+	INR	M	; index++
+	INX	H
+	JNZ	NLPT1-NLPT	; ( +5 )
+	INR	M
+NLPT1:	INX	H
+	INR	M	; index - limit ++
+	INX	H
+	JNZ	NLPT2-NLPT	; ( +12 )
+	INR	M
+NLPT2:	MOV	A,M
+	ORA	A
+	JM	0	; ( +18 )
+	INX	H
+NLPT3:	SHLD	RPP
+;
+; ( a --- a f ; Lay the step of LOOP in line when the loop body
+;   from a ( laid by <MARK ) is all machine code.
+;   f = 0 if it is not. )
+	DB	87H,'(NLOOP',')'+80H
+	DW	NLIT-9
+NLOOP	DW	$+2
+	LDA	NREG
+	ORA	A
+	JZ	NLOOP9	; laying the thread
+	POP	H
+	PUSH	H
+	INX	H
+	INX	H
+	XCHG		; DE <- a+2 ( the machine code of the body )
+	LHLD	NSTRT
+	CALL	CPHD
+	JNZ	NLOOP9	; the body is not all machine code
+	PUSH	B	; save IP
+	LHLD	UP+12H
+	PUSH	H	; save HERE
+	PUSH	D	; save a+2
+	XCHG		; DE <- HERE
+	LXI	H,NLPT
+	MVI	C,NLPT3+3-NLPT
+NLOOP1:	MOV	A,M
+	STAX	D
+	INX	H
+	INX	D
+	DCR	C
+	JNZ	NLOOP1
+	XCHG
+	SHLD	UP+12H	; DP <- HL
+	SHLD	NPUSH	; ( no push )
+	POP	B	; BC <- a+2
+	POP	D	; DE <- the code laid
+	LXI	H,20
+	DAD	D
+	MOV	M,B
+	DCX	H
+	MOV	M,C	; "JM a+2"
+	LXI	H,13
+	CALL	NLOOP2	; relocate "JNZ NLPT2"
+	LXI	H,6
+	CALL	NLOOP2	; relocate "JNZ NLPT1"
+	POP	B	; restore IP
+	LXI	H,1
+	JMP	HPUSH
+;
+; [DE+HL] <- [DE+HL] + DE
+NLOOP2:	DAD	D
+	MOV	A,M
+	ADD	E
+	MOV	M,A
+	INX	H
+	MOV	A,M
+	ADC	D
+	MOV	M,A
+	RET
+;
+NLOOP9:	LXI	H,0
+	JMP	HPUSH
+;
+; ( cfa --- f ; Lay the machine code of the word cfa at HERE.
+;   f = 0 if it is not in NATIVE mode, or the word cannot be
+;   laid in line. )
+	DB	88H,'(INLINE',')'+80H
+	DW	NLOOP-10
+INLIN	DW	$+2
+	POP	H	; HL <- cfa
+	PUSH	B	; save IP
+	XCHG
+	LHLD	NATV+2
+	MOV	A,H
+	ORA	L
+	JZ	INLIN9	; not in NATIVE mode
+	XCHG
+	PUSH	H	; save cfa
+	MOV	E,M
+	INX	H
+	MOV	D,M	; DE <- [cfa]
+	; a constant, a variable or a user variable
+	MVI	B,2AH	; "LHLD pfa"
+	LXI	H,DOCON
+	CALL	CPHD
+	JZ	INLN10
+	MVI	B,21H	; "LXI H,pfa"
+	LXI	H,DOVAR
+	CALL	CPHD
+	JZ	INLN10
+	LXI	H,DOUSE
+	CALL	CPHD
+	JZ	INLN11
+	; a primitive in NTAB
+	POP	H
+	PUSH	D	; save the code address
+	XCHG		; DE <- cfa
+	LXI	H,NTAB
+INLIN1:	MOV	A,M
+	INX	H
+	ORA	M
+	JZ	INLIN8	; end of the table
+	MOV	A,M
+	CMP	D
+	DCX	H
+	MOV	A,M
+	INX	H
+	INX	H
+	JNZ	INLIN1
+	CMP	E
+	JNZ	INLIN1
+	CALL	NOPEN
+	XCHG		; DE <- HERE
+	POP	H	; HL <- the code address
+	; Keep the top of the stack in the register: the pushes laid
+	; last and the pops at the head of the code cancel each other.
+INLN20:	PUSH	H
+	LHLD	NPUSH
+	CALL	CPHD
+	POP	H
+	JZ	INLN25	; no push left
+	DCX	D
+	LDAX	D	; A <- the push laid last
+	MOV	C,M	; C <- the head of the code
+	CPI	0E5H	; "PUSH H"
+	JZ	INLN21
+	MVI	B,62H	; "PUSH D / POP H" -> "MOV H,D / MOV L,E"
+	MOV	A,C
+	CPI	0D1H	; "POP D"
+	JZ	INLN22
+	CPI	0E1H	; "POP H"
+	JZ	INLN23
+	JMP	INLN24
+INLN21:	MVI	B,54H	; "PUSH H / POP D" -> "MOV D,H / MOV E,L"
+	MOV	A,C
+	CPI	0E1H	; "POP H"
+	JZ	INLN22
+	CPI	0D1H	; "POP D"
+	JNZ	INLN24
+INLN23:	MOV	A,B
+	STAX	D
+	INX	D
+	ADI	9	; "MOV L,E" or "MOV E,L"
+	STAX	D
+	INX	D
+	INX	H
+	XCHG
+	SHLD	NPUSH	; ( no push )
+	XCHG
+	JMP	INLN25
+INLN22:	INX	H	; drop both
+	JMP	INLN20
+INLN24:	INX	D	; ( no match )
+INLN25:	PUSH	D	; save the destination at the start
+	; copy the code up to the last jump
+INLIN2:	MOV	A,M
+	CPI	0C3H	; "JMP"
+	JNZ	INLIN3
+	PUSH	H	; save the source
+	PUSH	D	; save the destination
+	INX	H
+	MOV	E,M
+	INX	H
+	MOV	D,M	; DE <- the jump address
+	MVI	C,0	; C <- number of the pushes
+	LXI	H,NEXT
+	CALL	CPHD
+	JZ	INLIN4
+	INR	C
+	LXI	H,HPUSH
+	CALL	CPHD
+	JZ	INLIN4
+	INR	C
+	LXI	H,DPUSH
+	CALL	CPHD
+	JZ	INLIN4
+	POP	D
+	POP	H
+	MOV	A,M
+INLIN3:	STAX	D
+	INX	H
+	INX	D
+	JMP	INLIN2
+	; the end of the code
+INLIN4:	POP	H	; HL <- the destination
+	POP	D
+	POP	D	; DE <- the destination at the start
+	CALL	CPHD
+	JZ	INLN26	; ( no code laid : the pushes laid last remain )
+	SHLD	NPUSH
+INLN26:	MOV	A,C
+	CPI	2
+	JC	INLIN5
+	MVI	M,0D5H	; "PUSH D"
+	INX	H
+INLIN5:	ORA	A
+	JZ	INLIN6
+	MVI	M,0E5H	; "PUSH H"
+	INX	H
+INLIN6:	SHLD	UP+12H	; DP <- HL
+INLIN7:	POP	B	; restore IP
+	LXI	H,1
+	JMP	HPUSH
+INLIN8:	POP	D
+INLIN9:	POP	B	; restore IP
+	LXI	H,0
+	JMP	HPUSH
+	; a constant or a variable
+INLN10:	POP	H
+	INX	H
+	INX	H
+	XCHG		; DE <- pfa
+	CALL	NLAY
+	JMP	INLIN7
+	; a user variable
+INLN11:	POP	H
+	INX	H
+	INX	H
+	MOV	E,M
+	MVI	D,0
+	LXI	H,UP
+	DAD	D
+	XCHG		; DE <- the address of the user variable
+	MVI	B,21H	; "LXI H,a"
+	CALL	NLAY
+	JMP	INLIN7
+;
+FUSEL	EQU	INLIN-11
+	ENDIF
+	IF	NOT NATIV0
+FUSEL	EQU	SCSP-7
+	ENDIF
+;
+	IF	FUSE0
+;
+; ( --- a ; a: PEEPHOLE mode flag )
+;   When it is not 0, a pair of words compiled one after the
+;   other is replaced with one word of FTAB.
+	DB	88H,'PEEPHOL','E'+80H
+	DW	FUSEL
+PEEP	DW	DOVAR
+	DW	0
+LASTC	DW	0	; the address of the word compiled last
+;
+; ( n1 --- n2 ; n2 = n1 + [IP] ; LIT + )
+	DB	86H,'(LIT+',')'+80H
+	DW	PEEP-11
+LITP	DW	$+2
+	LDAX	B
+	MOV	E,A
+	INX	B
+	LDAX	B
+	MOV	D,A
+	INX	B
+	POP	H
+	DAD	D
+	JMP	HPUSH
+;
+; ( a --- a n ; DUP @ )
+	DB	86H,'(DUP@',')'+80H
+	DW	LITP-9
+DUPAT	DW	$+2
+	POP	H
+	PUSH	H
+	MOV	E,M
+	INX	H
+	MOV	D,M
+	PUSH	D
+	JMP	NEXT
+;
+; ( n1 n2 --- n1 n3 ; n3 = n1 + n2 ; OVER + )
+	DB	87H,'(OVER+',')'+80H
+	DW	DUPAT-9
+OVERP	DW	$+2
+	POP	D
+	POP	H
+	PUSH	H
+	DAD	D
+	JMP	HPUSH
+;
+; ( n1 n2 --- n2 ; SWAP DROP )
+	DB	85H,'(NIP',')'+80H
+	DW	OVERP-10
+NIP	DW	$+2
+	POP	H
+	POP	D
+	JMP	HPUSH
+;
+; ( --- n ; R@ @ )
+	DB	85H,'(R@@',')'+80H
+	DW	NIP-8
+RATAT	DW	$+2
+	LHLD	RPP
+	MOV	E,M
+	INX	H
+	MOV	D,M
+	XCHG
+	JMP	ATAT1
+;
+; ( a --- n ; @ @ )
+	DB	84H,'(@@',')'+80H
+	DW	RATAT-8
+ATAT	DW	$+2
+	POP	H
+	MOV	E,M
+	INX	H
+	MOV	D,M
+	XCHG
+ATAT1:	MOV	E,M
+	INX	H
+	MOV	D,M
+	PUSH	D
+	JMP	NEXT
+;
+; ( n1 n2 --- n1 n1 n2 ; OVER SWAP )
+	DB	8AH,'(OVERSWAP',')'+80H
+	DW	ATAT-7
+OVSW	DW	$+2
+	POP	D
+	POP	H
+	PUSH	H
+	PUSH	H
+	PUSH	D
+	JMP	NEXT
+;
+; The pairs of words and the word replacing them.
+FTAB:	DW	LIT,PLUS,LITP
+	DW	DUPE,ATT,DUPAT
+	DW	OVER,PLUS,OVERP
+	DW	SWAP,DROP,NIP
+	DW	RAT,ATT,RATAT
+	DW	ATT,ATT,ATAT
+	DW	OVER,SWAP,OVSW
+	DW	0	; end of the table
+;
+; ( cfa --- cfa / 0 ; In PEEPHOLE mode, if the word compiled last
+;   and the word cfa are a pair in FTAB, replace the former with
+;   the word of the pair and return 0. )
+	DB	86H,'(FUSE',')'+80H
+	DW	OVSW-13
+FUSE	DW	$+2
+	POP	D	; DE <- cfa
+	PUSH	B	; save IP
+	LHLD	PEEP+2
+	MOV	A,H
+	ORA	L
+	JZ	FUSE9	; not in PEEPHOLE mode
+	PUSH	D
+	LHLD	LASTC
+	MOV	E,M
+	INX	H
+	MOV	D,M
+	INX	H
+	MOV	C,E
+	MOV	B,D	; BC <- the word compiled last
+	; it must be followed by HERE (or its literal and HERE)
+	PUSH	H
+	LXI	H,LIT
+	CALL	CPHD
+	POP	H
+	JNZ	FUSE1
+	INX	H
+	INX	H
+FUSE1:	XCHG
+	LHLD	UP+12H	; HL <- HERE
+	CALL	CPHD
+	POP	D	; DE <- cfa
+	JNZ	FUSE9
+	; search FTAB for the pair BC DE
+	LXI	H,FTAB
+FUSE2:	PUSH	H
+	MOV	A,M
+	INX	H
+	ORA	M
+	JZ	FUSE8	; end of the table
+	DCX	H
+	MOV	A,M
+	INX	H
+	CMP	C
+	JNZ	FUSE3
+	MOV	A,M
+	INX	H
+	CMP	B
+	JNZ	FUSE3
+	MOV	A,M
+	INX	H
+	CMP	E
+	JNZ	FUSE3
+	MOV	A,M
+	INX	H
+	CMP	D
+	JNZ	FUSE3
+	; [LASTC] <- the word replacing them
+	MOV	E,M
+	INX	H
+	MOV	D,M
+	LHLD	LASTC
+	MOV	M,E
+	INX	H
+	MOV	M,D
+	POP	H
+	POP	B	; restore IP
+	LXI	H,0
+	JMP	HPUSH
+FUSE3:	POP	H
+	INX	H
+	INX	H
+	INX	H
+	INX	H
+	INX	H
+	INX	H
+	JMP	FUSE2
+FUSE8:	POP	H
+FUSE9:	POP	B	; restore IP
+	PUSH	D
+	JMP	NEXT
+;
+NCOMPL	EQU	FUSE-9
+	ENDIF
+	IF	NOT FUSE0
+NCOMPL	EQU	FUSEL
+	ENDIF
+;
+	IF	NATIV0 OR FUSE0
+;
+; ( cfa --- ; Compile the word cfa. )
+	DB	87H,'(NCOMP',')'+80H
+	DW	NCOMPL
+NCOMP	DW	DOCOL
+	IF	NATIV0
+	DW	DUPE
+	DW	INLIN
+	DW	ZBRAN,NCOMP1-$	; IF
+	DW	DROP
+	IF	FUSE0
+	DW	ZERO
+	DW	LIT,LASTC
+	DW	STORE
+	ENDIF
+	DW	BRAN,NCOMP2-$	; ELSE
+NCOMP1	DW	NTHR
+	ENDIF
+	IF	FUSE0
+	DW	FUSE
+	DW	QDUP
+	DW	ZBRAN,NCOMP2-$	;  IF
+	DW	HERE
+	DW	LIT,LASTC
+	DW	STORE
+	ENDIF
+	DW	COMMA
+				;  THEN
+				; THEN
+NCOMP2	DW	SEMIS
+;
+COMPL	EQU	NCOMP-10
+	ENDIF
+	IF	NOT (NATIV0 OR FUSE0)
+COMPL	EQU	SCSP-7
+	ENDIF
+;
+; ( --- ) <word>
+	DB	87H,'COMPIL','E'+80H
+	DW	COMPL
+COMP	DW	DOCOL
+	DW	QCOMP
+	DW	FROMR
+	DW	DUPE
+	DW	TWOP
+	DW	TOR
+	DW	ATT
+	IF	NATIV0
+	DW	NTHR
+	ENDIF
+	DW	COMMA
+	DW	SEMIS
+;
+; ( --- ) <word>
+	DB	0C9H,'[COMPILE',']'+80H
+	DW	COMP-10
+BCOMP	DW	DOCOL
+	DW	FIND
+	DW	QDUP
+	DW	ZEQU
+	DW	ZERO
+	DW	QERR
+	IF	NATIV0
+	DW	NTHR
+	ENDIF
+	DW	COMMA
+	DW	SEMIS
+;
+; ( n --- )
+	DB	0C7H,'LITERA','L'+80H
+	DW	BCOMP-12
+LITER	DW	DOCOL
+	DW	STATE
+	DW	ATT
+	DW	ZBRAN,LITER1-$	; IF
+	IF	NATIV0
+	DW	NATV
+	DW	ATT
+	DW	ZBRAN,LITER2-$	;  IF
+	DW	NLIT
+	DW	BRAN,LITER1-$	;  ELSE
+	ENDIF
+LITER2	DW	COMP
+	DW	LIT
+	DW	COMMA
+	IF	FUSE0
+	DW	HERE
+	DW	LIT,4
+	DW	SUBB
+	DW	LIT,LASTC
+	DW	STORE
+	ENDIF
+				;  THEN
+				; THEN
+LITER1	DW	SEMIS
+;
+; ( d --- )
+	DB	0C8H,'DLITERA','L'+80H
+	DW	LITER-10
+DLITE	DW	DOCOL
+	DW	STATE
+	DW	ATT
+	DW	ZBRAN,DLITE1-$	; IF
+	DW	SWAP
+	DW	LITER		;  [COMPILE] LITERAL
+	DW	LITER		;  [COMPILE] LITERAL
+				; THEN
+DLITE1	DW	SEMIS
+;
+; ( --- )
+	DB	8BH,'DEFINITION','S'+80H
+	DW	DLITE-11
+DEFIN	DW	DOCOL
+	DW	CONT
+	DW	ATT
+	DW	CURR
+	DW	STORE
+	DW	SEMIS
+;
+; ( n --- )
+	DB	85H,'ALLO','T'+80H
+	DW	DEFIN-14
+ALLOT	DW	DOCOL
+	DW	DP
 	DW	PSTOR
 	DW	SEMIS
 ;
@@ -2757,6 +4686,9 @@ PFA	DW	DOCOL
 	DB	0C1H,'['+80H
 	DW	PFA-6
 LBRAC	DW	DOCOL
+	IF	NATIV0
+	DW	NTHR
+	ENDIF
 	DW	ZERO
 	DW	STATE
 	DW	STORE
@@ -2828,6 +4760,18 @@ VOCAB	DW	DOCOL
 	DW	COMMA
 	DW	VOCL
 	DW	STORE
+	IF	HASHED
+	DW	CURR		; parent vocabulary
+	DW	ATT
+	DW	COMMA
+	DW	MONE		; ( all its words visible )
+	DW	COMMA
+	DW	HERE		; buckets
+	DW	LIT,NHASH0*2
+	DW	DUPE
+	DW	ALLOT
+	DW	ERASE
+	ENDIF
 	DW	PSCOD
 DOVOC:	JMP	XDOES
 	DW	TWOP
@@ -2842,6 +4786,11 @@ FORTH	DW	DOVOC
 	DW	0A081H		; "blank" word (= 81H,' '+80H)
 	DW	STAN79-14	; latest word
 	DW	0
+	IF	HASHED
+	DW	0		; ( no parent )
+	DW	0
+	DS	NHASH0*2	; buckets
+	ENDIF
 ;
 ; ( --- ) <word>
 	DB	86H,'FORGE','T'+80H
@@ -2858,11 +4807,15 @@ FORG	DW	DOCOL
 	DW	DUPE
 	DW	FENCE
 	DW	ATT
-	DW	LESS
+	DW	ULESS
 	DW	LIT,15H
 	DW	QERR
 	DW	DUPE
 	DW	NFA
+	IF	HASHED
+	DW	LIT,4		; the index node
+	DW	SUBB
+	ENDIF
 	DW	DP
 	DW	STORE
 	DW	LFA
@@ -2870,12 +4823,70 @@ FORG	DW	DOCOL
 	DW	CURR
 	DW	ATT
 	DW	STORE
+	IF	HASHED
+	DW	HPRUNE
+	ENDIF
+	DW	SEMIS
+;
+; ( --- ; Forget the words and vocabularies above HERE
+;         from every vocabulary. )
+	DB	86H,'(TRIM',')'+80H
+	DW	FORG-9
+TRIM	DW	DOCOL
+				; BEGIN
+TRIM1	DW	VOCL
+	DW	ATT
+	DW	HERE
+	DW	ULESS
+	DW	ZEQU
+	DW	ZBRAN,TRIM2-$	; WHILE
+	DW	VOCL
+	DW	ATT
+	DW	ATT
+	DW	VOCL
+	DW	STORE
+	DW	BRAN,TRIM1-$	; REPEAT
+TRIM2	DW	VOCL
+	DW	ATT
+				; BEGIN
+TRIM3	DW	QDUP
+	DW	ZBRAN,TRIM6-$	; WHILE
+	DW	DUPE
+	DW	TWOM		; latest word
+	DW	DUPE
+	DW	ATT
+				;  BEGIN
+TRIM4	DW	DUPE
+	DW	HERE
+	DW	ULESS
+	DW	ZEQU
+	DW	ZBRAN,TRIM5-$	;  WHILE
+	DW	PFA
+	DW	LFA
+	DW	ATT
+	DW	BRAN,TRIM4-$	;  REPEAT
+TRIM5	DW	SWAP
+	DW	STORE
+	DW	ATT
+	DW	BRAN,TRIM3-$	; REPEAT
+TRIM6	EQU	$
+	IF	HASHED
+	DW	HPRUNE
+	ENDIF
 	DW	SEMIS
 ;
 ; ( --- DP )
 	DB	85H,'<MAR','K'+80H
-	DW	FORG-9
+	DW	TRIM-9
 LMARK	DW	DOCOL
+	IF	NATIV0
+	DW	NTHR
+	ENDIF
+	IF	FUSE0
+	DW	ZERO
+	DW	LIT,LASTC
+	DW	STORE
+	ENDIF
 	DW	HERE
 	DW	SEMIS
 ;
@@ -2901,6 +4912,14 @@ LRESOL	DW	DOCOL
 	DB	88H,'>RESOLV','E'+80H
 	DW	LRESOL-11
 GRESOL	DW	DOCOL
+	IF	NATIV0
+	DW	NTHR
+	ENDIF
+	IF	FUSE0
+	DW	ZERO
+	DW	LIT,LASTC
+	DW	STORE
+	ENDIF
 	DW	HERE
 	DW	OVER
 	DW	SUBB
@@ -3014,10 +5033,17 @@ DO	DW	DOCOL
 LOOPC	DW	DOCOL
 	DW	TWO
 	DW	QPAIR
-	DW	COMP
+	IF	NATIV0
+	DW	NLOOP
+	DW	ZBRAN,LOOPC1-$	; IF
+	DW	DROP
+	DW	BRAN,LOOPC2-$	; ELSE
+	ENDIF
+LOOPC1	DW	COMP
 	DW	XLOOP
 	DW	LRESOL
-	DW	SEMIS
+				; THEN
+LOOPC2	DW	SEMIS
 ;
 ; ( a 2 --- : compiling ; --- : execution )
 	DB	0C5H,'+LOO','P'+80H
@@ -3035,13 +5061,12 @@ PLOOP	DW	DOCOL
 	DW	PLOOP-8
 LLEAVE	DW	$+2
 	LHLD	RPP
-	MOV	E,M
 	INX	H
-	MOV	D,M	; DE <- i
 	INX	H
-	MOV	M,E
+	XRA	A
+	MOV	M,A
 	INX	H
-	MOV	M,D	; limit_i <- DE (i.e. limit_i = i)
+	MOV	M,A	; index - limit <- 0
 	JMP	NEXT
 ;
 ; ( --- n ; n = loop counter )
@@ -3054,7 +5079,7 @@ IDO	DW	RAT+2
 	DW	IDO-4
 JDO	DW	$+2
 	LHLD	RPP
-	LXI	D,4	; Return Stack : ... limit_j j limit_i i
+	LXI	D,4	; Return Stack : ... j-limit_j j i-limit_i i
 	DAD	D
 	MOV	E,M
 	INX	H
@@ -3141,26 +5166,97 @@ LROLL	DW	DOCOL
 	DW	STORE
 	DW	SEMIS
 ;
-; ( --- cfa / 0 ) <name>
-	DB	84H,'FIN','D'+80H
+	IF	LITFS0
+; ( a --- f ; f: true if the token at a is digits in BASE
+;                ( with '-' ), beginning with 0 ... 9. )
+	DB	89H,'(DIGITS?',')'+80H
 	DW	LROLL-8
-FIND	DW	DOCOL
-	DW	BLS
-	DW	WORDS
+QDIGS	DW	$+2
+	POP	H	; HL <- a
+	PUSH	B	; save IP
+	LXI	D,0	; DE <- false
+	MOV	C,M	; C <- length
+	INX	H
+	MOV	A,M
+	CPI	2DH	; '-'
+	JNZ	QDIG1
+	INX	H
+	DCR	C
+	JZ	QDIG4
+QDIG1:	MOV	A,M
+	SUI	30H	; '0'
+	CPI	10
+	JNC	QDIG4
+	LDA	UP+27H	; BASE ( high )
+	ORA	A
+	JNZ	QDIG4
+	LDA	UP+26H	; BASE ( low )
+	MOV	B,A
+	; all digits ?
+QDIG2:	MOV	A,M
+	SUI	30H	; '0'
+	JC	QDIG4
+	CPI	10
+	JC	QDIG3
+	SUI	7	; ( 'A' -> 10 )
+	CPI	10
+	JC	QDIG4
+QDIG3:	CMP	B
+	JNC	QDIG4
+	INX	H
+	DCR	C
+	JNZ	QDIG2
+	INX	D	; true
+QDIG4:	POP	B	; restore IP
+	XCHG
+	JMP	HPUSH
+;
+SRCHL	EQU	QDIGS-12
+	ENDIF
+	IF	NOT LITFS0
+SRCHL	EQU	LROLL-8
+	ENDIF
+;
+; ( a --- cfa / 0 ; Search the token at a ( = HERE )
+;                   in CONTEXT and CURRENT. )
+	DB	88H,'(SEARCH',')'+80H
+	DW	SRCHL
+SRCH	DW	DOCOL
 	DW	CONT
 	DW	ATT
+	IF	HASHED
+	DW	HFIND
+	ENDIF
+	IF	NOT HASHED
 	DW	ATT
 	DW	PFIND
+	ENDIF
 	DW	DUPE
 	DW	ZEQU
 	DW	ZBRAN,FIND1-$	; IF
 	DW	DROP
 	DW	HERE
+	IF	HASHED
+	DW	CURR
+	DW	ATT
+	DW	HFIND
+	ENDIF
+	IF	NOT HASHED
 	DW	LATES
 	DW	PFIND
+	ENDIF
 				; THEN
 FIND1	DW	SEMIS
 ;
+; ( --- cfa / 0 ) <name>
+	DB	84H,'FIN','D'+80H
+	DW	SRCH-11
+FIND	DW	DOCOL
+	DW	BLS
+	DW	WORDS
+	DW	SRCH
+	DW	SEMIS
+;
 ; ( --- pfa : execution ; --- : compiling ) <name>
 	DB	0C1H,''''+80H	; word "'"
 	DW	FIND-7
@@ -3192,23 +5288,9 @@ WORDS2	DW	INN
 	DW	ATT
 	DW	PLUS
 	DW	SWAP
-	DW	ENCL
-	DW	HERE
-	DW	LIT,MXTOKN+2
-	DW	BLANK
+	DW	WORDP
 	DW	INN
 	DW	PSTOR
-	DW	OVER
-	DW	SUBB
-	DW	TOR
-	DW	RAT
-	DW	HERE
-	DW	CSTOR
-	DW	PLUS
-	DW	HERE
-	DW	ONEP
-	DW	FROMR
-	DW	CMOVEE
 	DW	HERE
 	DW	SEMIS
 ;
@@ -3239,10 +5321,15 @@ EXPEC1	DW	KEY
 	DW	IDO
 	DW	EQUAL
 	DW	DUPE
-	DW	FROMR
 	DW	TWOM
+	DW	FROMR		;   ( Move the index and index - limit. )
+	DW	OVER
+	DW	PLUS
+	DW	FROMR
+	DW	ROT
 	DW	PLUS
 	DW	TOR
+	DW	TOR
 	DW	ZBRAN,EXPEC6-$	;   IF
 	DW	LIT,7H		;    ( bell code )
 	DW	BRAN,EXPEC7-$	;   ELSE
@@ -3320,9 +5407,107 @@ NULL1	DW	FROMR
 NULL2	DW	SEMIS
 ;
 ; ( d a --- d' a' )
-	DB	87H,'CONVER','T'+80H
+; ( d1 a1 --- d2 a2 )
+; CONVERT for BASE 10 or 16 while d2 is a single number,
+; by shifts and adds. a2 is the address before the character
+; not converted ( the overflowing digit or not a digit ).
+	DB	89H,'(CONVERT',')'+80H
 	DW	NULL-4
+PCONV	DW	$+2
+	POP	D	; DE <- a1
+	POP	H	; HL <- the high cell of d1
+	MOV	A,H
+	ORA	L
+	JNZ	PCNV9	; ( a double number )
+	LDA	UP+27H	; BASE ( high )
+	ORA	A
+	JNZ	PCNV9
+	LDA	UP+26H	; BASE ( low )
+	CPI	10
+	JZ	PCNV1
+	CPI	16
+	JNZ	PCNV9
+PCNV1:	POP	H	; HL <- the low cell of d1
+	PUSH	B	; save IP
+	MOV	B,A	; B <- BASE
+	; A <- digit of the next character
+PCNV2:	INX	D
+	LDAX	D
+	SUI	30H	; '0'
+	JC	PCNV8
+	CPI	10
+	JC	PCNV3
+	MOV	C,A
+	MOV	A,B
+	CPI	16
+	JNZ	PCNV8
+	MOV	A,C
+	SUI	7	; ( 'A' -> 10 )
+	CPI	10
+	JC	PCNV8
+	CPI	16
+	JNC	PCNV8
+	; HL <- HL * BASE + digit ( if not overflow )
+PCNV3:	MOV	C,A	; C <- digit
+	PUSH	D	; save address
+	PUSH	H	; save HL
+	MOV	A,B
+	CPI	16
+	JZ	PCNV4
+	MOV	D,H	; ( x 10 = ( x 4 + x ) x 2 )
+	MOV	E,L
+	DAD	H
+	JC	PCNV7
+	DAD	H
+	JC	PCNV7
+	DAD	D
+	JC	PCNV7
+	DAD	H
+	JC	PCNV7
+	JMP	PCNV5
+PCNV4:	DAD	H	; ( x 16 )
+	JC	PCNV7
+	DAD	H
+	JC	PCNV7
+	DAD	H
+	JC	PCNV7
+	DAD	H
+	JC	PCNV7
+PCNV5:	MOV	E,C
+	MVI	D,0
+	DAD	D
+	JC	PCNV7
+	POP	D
+	POP	D	; restore address
+	; if DPL <> -1 then DPL <- DPL + 1
+	PUSH	H
+	LHLD	UP+28H
+	INX	H
+	MOV	A,H
+	ORA	L
+	JZ	PCNV6
+	SHLD	UP+28H
+PCNV6:	POP	H
+	JMP	PCNV2
+	; overflow
+PCNV7:	POP	H	; HL <- HL before the digit
+	POP	D	; restore address
+PCNV8:	DCX	D
+	POP	B	; restore IP
+	PUSH	H	; d2 ( low )
+	LXI	H,0	; d2 ( high )
+	PUSH	H
+	XCHG
+	JMP	HPUSH
+PCNV9:	PUSH	H
+	XCHG
+	JMP	HPUSH
+;
+; ( d1 a1 --- d2 a2 )
+	DB	87H,'CONVER','T'+80H
+	DW	PCONV-12
 CONV	DW	DOCOL
+	DW	PCONV
 				; BEGIN
 CONV1	DW	ONEP
 	DW	DUPE
@@ -3369,34 +5554,412 @@ NUMB	DW	DOCOL
 	DW	DUPE
 	DW	TOR
 	DW	PLUS
-	DW	MONE
-				; BEGIN
-NUMB1	DW	DPL
+	DW	MONE
+				; BEGIN
+NUMB1	DW	DPL
+	DW	STORE
+	DW	CONV
+	DW	DUPE
+	DW	CAT
+	DW	BLS
+	DW	SUBB
+	DW	ZBRAN,NUMB2-$	; WHILE
+	DW	DUPE
+	DW	CAT
+	DW	LIT,2EH		;  ( '.' code )
+	DW	SUBB
+	DW	ZERO
+	DW	QERR
+	DW	ZERO
+	DW	BRAN,NUMB1-$	; REPEAT
+NUMB2	DW	DROP
+	DW	FROMR
+	DW	ZBRAN,NUMB3-$	; IF
+	DW	DMINUS		;  DNEGATE
+				; THEN
+NUMB3	DW	SEMIS
+;
+; ( n --- a / ff ; Search the buffer of the block n. )
+; a : buffer address ( The reference flag is set. )
+; ff: false flag
+	DB	87H,'(BFIND',')'+80H
+	DW	NUMB-9
+BFIND	DW	$+2
+	POP	D	; DE <- n
+	MOV	A,D
+	ANI	7FH
+	MOV	D,A
+	; HL <- bucket address
+	MOV	A,E
+	ANI	BHASH0-1
+	ADD	A
+	MOV	L,A
+	MVI	H,0
+	PUSH	D
+	LXI	D,BHTAB
+	DAD	D
+	POP	D
+	; HL <- [HL] ( = next buffer )
+BFIND1:	MOV	A,M
+	INX	H
+	MOV	H,M
+	MOV	L,A
+	; if HL == 0 then not find
+	ORA	H
+	JZ	HPUSH	; false
+	; if [HL] & 7FFFH == DE then jump to BFIND3
+	MOV	A,M
+	CMP	E
+	JNZ	BFIND2
+	INX	H
+	MOV	A,M
+	DCX	H
+	ANI	7FH
+	CMP	D
+	JZ	BFIND3
+	; HL <- address of next
+BFIND2:	PUSH	D
+	LXI	D,BBUF0+4
+	DAD	D
+	POP	D
+	JMP	BFIND1
+	; found
+BFIND3:	PUSH	H
+	LXI	D,BBUF0+6
+	DAD	D
+	MVI	M,1	; reference flag
+	POP	H
+	JMP	HPUSH
+;
+; ( n a --- ; Rechain the buffer a for the block n. )
+; a is searched for only in the chain of its old block [a].
+	DB	87H,'(BLINK',')'+80H
+	DW	BFIND-10
+BLINK	DW	$+2
+	POP	H	; HL <- a
+	POP	D	; DE <- n
+	PUSH	B	; save IP
+	PUSH	D	; save n
+	XCHG		; DE <- a
+	; HL <- bucket address of [a]
+	LDAX	D
+	ANI	BHASH0-1
+	ADD	A
+	MOV	C,A
+	MVI	B,0
+	LXI	H,BHTAB
+	DAD	B
+	; unlink a from the hash chain
+	; if [HL+1][HL] == DE then jump to BLINK4
+BLINK2:	MOV	A,M
+	CMP	E
+	JNZ	BLINK3
+	INX	H
+	MOV	A,M
+	DCX	H
+	CMP	D
+	JZ	BLINK4
+	; HL <- [HL] ( = next buffer )
+BLINK3:	MOV	A,M
+	INX	H
+	MOV	H,M
+	MOV	L,A
+	; if HL == 0 then a is not chained
+	ORA	H
+	JZ	BLINK6
+	; HL <- address of next
+	PUSH	D
+	LXI	D,BBUF0+4
+	DAD	D
+	POP	D
+	JMP	BLINK2
+	; [HL+1][HL] <- next of a
+BLINK4:	XCHG		; DE <- HL, HL <- a
+	PUSH	H	; save a
+	LXI	B,BBUF0+4
+	DAD	B
+	MOV	A,M
+	STAX	D
+	INX	H
+	INX	D
+	MOV	A,M
+	STAX	D
+	POP	D	; DE <- a
+	; [a+1][a] <- n
+BLINK6:	POP	H	; HL <- n
+	XCHG		; HL <- a, DE <- n
+	MOV	M,E
+	INX	H
+	MOV	M,D
+	DCX	H
+	PUSH	H	; save a
+	; DE <- bucket address
+	MOV	A,E
+	ANI	BHASH0-1
+	ADD	A
+	MOV	C,A
+	MVI	B,0
+	LXI	H,BHTAB
+	DAD	B
+	XCHG
+	; next of a <- [bucket]
+	POP	H	; HL <- a
+	PUSH	H
+	LXI	B,BBUF0+4
+	DAD	B
+	LDAX	D
+	MOV	M,A
+	INX	D
+	INX	H
+	LDAX	D
+	MOV	M,A
+	; [bucket] <- a
+	POP	H	; HL <- a
+	XCHG		; DE <- a, HL <- bucket address + 1
+	MOV	M,D
+	DCX	H
+	MOV	M,E
+	POP	B	; restore IP
+	JMP	NEXT
+;
+;
+; ***** Screen Cache *****
+;
+; The 8 blocks of the screen last reached by (LINE) are held in
+; one piece of 1024 bytes below FIRST. The editor works on the
+; screen there, and only the blocks updated are written back when
+; another screen is reached, or by SAVE-BUFFERS. The blocks of the
+; cache are out of the buffers while it holds them, and are put
+; back there when it is released.
+;
+PINB	DW	8000H	; the first block of the screen ( 8000H: none )
+PINF	DW	BSCR0	; the first block updated ( in the screen )
+PINE	DW	-1	; the last block updated ( in the screen )
+PINL	DW	0	; the block of the line reached last + 1 ( or 0 )
+PINA	DW	0	; the address of the cache ( set by the cold start )
+;
+; ( --- ; Release the cache. )
+PFREE	DW	DOCOL
+	DW	LIT,8000H
+	DW	LIT,PINB
+	DW	STORE
+	DW	BSCR
+	DW	LIT,PINF
+	DW	STORE
+	DW	LIT,-1
+	DW	LIT,PINE
+	DW	STORE
+	DW	ZERO
+	DW	LIT,PINL
+	DW	STORE
+	DW	SEMIS
+;
+; ( n --- ; Mark the block n of the screen in the cache updated. )
+PUPD	DW	DOCOL
+	DW	DUPE
+	DW	LIT,PINF
+	DW	ATT
+	DW	MIN
+	DW	LIT,PINF
+	DW	STORE
+	DW	LIT,PINE
+	DW	ATT
+	DW	MAX
+	DW	LIT,PINE
+	DW	STORE
+	DW	SEMIS
+;
+; ( n1 n2 --- f ; f: the blocks n1, n1+1, ..., n1+n2-1 and
+;   the screen in the cache overlap. )
+PINND	DW	DOCOL
+	DW	LIT,BSCR0-1
+	DW	PLUS
+	DW	SWAP
+	DW	LIT,PINB
+	DW	ATT
+	DW	SWAP
+	DW	SUBB
+	DW	LIT,BSCR0-1
+	DW	PLUS
+	DW	SWAP
+	DW	ULESS
+	DW	SEMIS
+;
+; ( --- ; Write the updated blocks of the cache back in one
+;   transfer, release the cache and put its blocks in the buffers. )
+	DB	87H,'(UNPIN',')'+80H
+	DW	BLINK-10
+UNPIN	DW	DOCOL
+	DW	LIT,PINB
+	DW	ATT
+	DW	TOR
+	DW	LIT,PINE
+	DW	ATT
+	DW	LIT,PINF
+	DW	ATT
+	DW	SUBB
+	DW	ONEP
+	DW	DUPE
+	DW	ZGREAT
+	DW	ZBRAN,UNPIN1-$	; IF
+	DW	LIT,PINF
+	DW	ATT
+	DW	DUPE
+	DW	BBUF
+	DW	STAR
+	DW	LIT,PINA
+	DW	ATT
+	DW	PLUS
+	DW	SWAP
+	DW	LIT,PINB
+	DW	ATT
+	DW	PLUS		;  n a blk
+	DW	LIT,DRSIZ
+	DW	BSCR
+	DW	STAR
+	DW	SLMOD		;  n a n2 drv
+	DW	PFREE		;  ( released before an error )
+	DW	SWAP
+	DW	ROT
+	DW	SWAP
+	DW	LIT,4
+	DW	ROLL
+	DW	WRRECS
+	DW	DUPE
+	DW	LIT,9H		;  ( error #9 )
+	DW	QERR
+	DW	DSKERR
+	DW	STORE
+	DW	BRAN,UNPIN2-$	; ELSE
+UNPIN1	DW	DROP
+	DW	PFREE
+				; THEN
+UNPIN2	DW	FROMR
+	DW	DUPE
+	DW	ZLESS
+	DW	ZEQU
+	DW	ZBRAN,UNPIN4-$	; IF
+	DW	BSCR
+	DW	ZERO
+	DW	XDO		;  DO
+UNPIN3	DW	LIT,PINA
+	DW	ATT
+	DW	IDO
+	DW	BBUF
+	DW	STAR
+	DW	PLUS
+	DW	OVER
+	DW	IDO
+	DW	PLUS
+	DW	BUFFE
+	DW	BBUF
+	DW	CMOVEE
+	DW	XLOOP,UNPIN3-$	;  LOOP
+				; THEN
+UNPIN4	DW	DROP
+	DW	SEMIS
+;
+; ( n --- ; Read the screen from the block n on into the cache.
+;   The blocks in the buffers are taken from there, and the disk
+;   is not read when all of them are. )
+PREAD	DW	DOCOL
+	DW	ZERO
+	DW	BSCR
+	DW	ZERO
+	DW	XDO		; DO
+PREAD4	DW	OVER
+	DW	IDO
+	DW	PLUS
+	DW	BFIND
+	DW	ZEQU
+	DW	ORR
+	DW	XLOOP,PREAD4-$	; LOOP
+	DW	ZBRAN,PREAD5-$	; IF
+	DW	DUPE
+	DW	LIT,DRSIZ
+	DW	BSCR
+	DW	STAR
+	DW	SLMOD
+	DW	LIT,PINA
+	DW	ATT
+	DW	ROT
+	DW	BSCR
+	DW	RDRECS
+	DW	DUPE
+	DW	LIT,8H		;  ( error #8 )
+	DW	QERR
+	DW	DSKERR
+	DW	STORE
+				; THEN
+PREAD5	DW	BSCR
+	DW	ZERO
+	DW	XDO		; DO
+PREAD1	DW	DUPE
+	DW	IDO
+	DW	PLUS
+	DW	BFIND
+	DW	QDUP
+	DW	ZBRAN,PREAD2-$	;  IF
+	DW	DUPE
+	DW	TWOP
+	DW	LIT,PINA
+	DW	ATT
+	DW	IDO
+	DW	BBUF
+	DW	STAR
+	DW	PLUS
+	DW	BBUF
+	DW	CMOVEE
+	DW	DUPE
+	DW	ATT
+	DW	ZLESS
+	DW	ZBRAN,PREAD3-$	;   IF
+	DW	IDO
+	DW	PUPD
+				;   THEN
+PREAD3	DW	LIT,7FFFH	;   ( Discard the buffer. )
+	DW	SWAP
+	DW	BLINK
+				;  THEN
+PREAD2	DW	XLOOP,PREAD1-$	; LOOP
+	DW	LIT,PINB
 	DW	STORE
-	DW	CONV
+	DW	SEMIS
+;
+; ( n1 n2 --- a ; a: the address of the byte n1 of the block n2
+;   in the cache, reading the screen of the block n2 into it. )
+	DB	85H,'(PIN',')'+80H
+	DW	UNPIN-10
+PIN	DW	DOCOL
+	DW	BSCR
+	DW	SLMOD
+	DW	BSCR
+	DW	STAR		; n1 n3 n4 ( n4: the first block )
 	DW	DUPE
-	DW	CAT
-	DW	BLS
+	DW	LIT,PINB
+	DW	ATT
 	DW	SUBB
-	DW	ZBRAN,NUMB2-$	; WHILE
+	DW	ZBRAN,PIN1-$	; IF
+	DW	UNPIN
 	DW	DUPE
-	DW	CAT
-	DW	LIT,2EH		;  ( '.' code )
-	DW	SUBB
-	DW	ZERO
-	DW	QERR
-	DW	ZERO
-	DW	BRAN,NUMB1-$	; REPEAT
-NUMB2	DW	DROP
-	DW	FROMR
-	DW	ZBRAN,NUMB3-$	; IF
-	DW	DMINUS		;  DNEGATE
+	DW	PREAD
 				; THEN
-NUMB3	DW	SEMIS
+PIN1	DW	DROP
+	DW	DUPE
+	DW	ONEP
+	DW	LIT,PINL
+	DW	STORE
+	DW	BBUF
+	DW	STAR
+	DW	PLUS
+	DW	LIT,PINA
+	DW	ATT
+	DW	PLUS
+	DW	SEMIS
 ;
 ; ( a1 --- a2 f )
 	DB	84H,'+BU','F'+80H
-	DW	NUMB-9
+	DW	PIN-8
 PBUF	DW	DOCOL
 	DW	BFLEN
 	DW	PLUS
@@ -3417,7 +5980,14 @@ PBUF1	DW	DUPE
 	DB	86H,'UPDAT','E'+80H
 	DW	PBUF-7
 UPDAT	DW	DOCOL
-	DW	PREV
+	DW	LIT,PINL
+	DW	ATT
+	DW	QDUP
+	DW	ZBRAN,UPDAT1-$	; IF ( a line in the screen cache )
+	DW	ONEM
+	DW	PUPD
+	DW	BRAN,UPDAT2-$	; ELSE
+UPDAT1	DW	PREV
 	DW	ATT
 	DW	ATT
 	DW	LIT,8000H	; ( Set the MSB. )
@@ -3434,7 +6004,8 @@ UPDAT	DW	DOCOL
 	DW	TWOP
 	DW	STORE
 ;
-	DW	SEMIS
+				; THEN
+UPDAT2	DW	SEMIS
 ;
 ; ( --- )
 	DB	8DH,'EMPTY-BUFFER','S'+80H
@@ -3445,25 +6016,156 @@ EMPBUF	DW	DOCOL
 	DW	OVER
 	DW	SUBB
 	DW	ERASE
+	DW	LIT,BHTAB
+	DW	LIT,BHASH0*2
+	DW	ERASE
+	DW	PFREE
+	DW	LIT,0FFH	; ( Select the drive anew. )
+	DW	LIT,CDRV
+	DW	CSTOR
 	DW	SEMIS
 ;
-; ( --- )
-	DB	8CH,'SAVE-BUFFER','S'+80H
+; ( --- a / ff ; a: the updated buffer of the least block number )
+	DB	89H,'(UPDATED',')'+80H
 	DW	EMPBUF-16
-SAVBUF	DW	DOCOL
-	DW	NUMBUF
+UPDTD	DW	DOCOL
+	DW	ZERO
+	DW	FIRST
+				; BEGIN
+UPDTD1	DW	DUPE
+	DW	LIMIT
+	DW	ULESS
+	DW	ZBRAN,UPDTD2-$	; WHILE
+	DW	DUPE
+	DW	ATT
+	DW	ZLESS
+	DW	ZBRAN,UPDTD3-$	;  IF
+	DW	OVER
+	DW	ZBRAN,UPDTD4-$	;   IF
+	DW	OVER
+	DW	ATT
+	DW	OVER
+	DW	ATT
+	DW	GREAT
+	DW	BRAN,UPDTD5-$	;   ELSE
+UPDTD4	DW	ONE
+				;   THEN
+UPDTD5	DW	ZBRAN,UPDTD3-$	;   IF
+	DW	SWAP
+	DW	DROP
+	DW	DUPE
+				;   THEN
+				;  THEN
+UPDTD3	DW	BFLEN
+	DW	PLUS
+	DW	BRAN,UPDTD1-$	; REPEAT
+UPDTD2	DW	DROP
+	DW	SEMIS
+;
+; ( a --- ; Write the updated buffer a with the following ones
+;           of the succeeding blocks in one transfer. )
+	DB	86H,'(WRUN',')'+80H
+	DW	UPDTD-12
+WRUN	DW	DOCOL
+	DW	DUPE
+	DW	ATT
+	DW	LIT,7FFFH
+	DW	ANDD
+	DW	ONE		; a n len
+				; BEGIN
+WRUN1	DW	TDUP
+	DW	PLUS
+	DW	LIT,DRSIZ
+	DW	BSCR
+	DW	STAR
+	DW	MODD
+	DW	ZBRAN,WRUN2-$	;  IF ( not the next drive )
+	DW	DUPE
+	DW	BFLEN
+	DW	STAR
+	DW	LIT,4
+	DW	PICK
+	DW	PLUS
+	DW	DUPE
+	DW	LIMIT
+	DW	ULESS
+	DW	ZBRAN,WRUN3-$	;   IF
+	DW	ATT
+	DW	THREE
+	DW	PICK
+	DW	THREE
+	DW	PICK
+	DW	PLUS
+	DW	LIT,8000H
+	DW	ORR
+	DW	EQUAL
+	DW	BRAN,WRUN4-$	;   ELSE
+WRUN3	DW	DROP
+	DW	ZERO
+				;   THEN
+WRUN4	DW	BRAN,WRUN5-$	;  ELSE
+WRUN2	DW	ZERO
+				;  THEN
+WRUN5	DW	ZBRAN,WRUN6-$	; WHILE
 	DW	ONEP
+	DW	BRAN,WRUN1-$	; REPEAT
+WRUN6	DW	TOR
+	DW	LIT,DRSIZ
+	DW	BSCR
+	DW	STAR
+	DW	SLMOD		; a n2 drv
+	DW	THREE
+	DW	PICK
+	DW	TWOP
+	DW	ROT
+	DW	RAT
+	DW	WRBUFS
+	DW	DUPE
+	DW	LIT,9H		; ( error #9 )
+	DW	QERR
+	DW	DSKERR
+	DW	STORE
+	DW	FROMR
 	DW	ZERO
 	DW	XDO		; DO
-SAVBU1	DW	ZERO
-	DW	BUFFE
+WRUN7	DW	DUPE
+	DW	IDO
+	DW	BFLEN
+	DW	STAR
+	DW	PLUS
+	DW	DUPE
+	DW	ATT
+	DW	LIT,7FFFH
+	DW	ANDD
+	DW	SWAP
+	DW	STORE		;  ( Clear the update flag. )
+	DW	XLOOP,WRUN7-$	; LOOP
 	DW	DROP
-	DW	XLOOP,SAVBU1-$	; LOOP
 	DW	SEMIS
 ;
 ; ( --- )
-	DB	83H,'DR','0'+80H
+	DB	8CH,'SAVE-BUFFER','S'+80H
+	DW	WRUN-9
+SAVBUF	DW	DOCOL
+	DW	UNPIN
+				; BEGIN
+SAVBU1	DW	UPDTD
+	DW	QDUP
+	DW	ZBRAN,SAVBU2-$	; WHILE
+	DW	WRUN
+	DW	BRAN,SAVBU1-$	; REPEAT
+SAVBU2	DW	SEMIS
+;
+; ( --- )
+	DB	85H,'FLUS','H'+80H
 	DW	SAVBUF-15
+FLUSH	DW	DOCOL
+	DW	SAVBUF
+	DW	SEMIS
+;
+; ( --- )
+	DB	83H,'DR','0'+80H
+	DW	FLUSH-8
 DRZER	DW	DOCOL
 	DW	ZERO
 	DW	OFSET
@@ -3508,10 +6210,10 @@ RSLW2	DW	OVER
 	DW	QERR
 	DW	DUPE
 	DW	ZBRAN,RSLW3-$	; IF
-	DW	ZERO
+	DW	LIT,7FFFH
 	DW	PREV
 	DW	ATT
-	DW	STORE		;  ( This buffer is no good. )
+	DW	BLINK		;  ( This buffer is no good. )
 				; THEN
 RSLW3	DW	DSKERR
 	DW	STORE
@@ -3521,89 +6223,315 @@ RSLW3	DW	DSKERR
 	DB	86H,'BUFFE','R'+80H
 	DW	RSLW-6
 BUFFE	DW	DOCOL
-	DW	USE
+	DW	ZERO
+	DW	LIT,PINL
+	DW	STORE
+	DW	DUPE
+	DW	ONE
+	DW	PINND
+	DW	ZBRAN,BUFFE1-$	; IF
+	DW	UNPIN
+	DW	DUPE
+	DW	BFIND
+	DW	QDUP
+	DW	ZBRAN,BUFFE1-$	;  IF
+	DW	LIT,7FFFH	;   ( Discard the copy put back. )
+	DW	SWAP
+	DW	BLINK
+				;  THEN
+				; THEN
+				; BEGIN
+BUFFE1	DW	USE
 	DW	ATT
 	DW	DUPE
+	DW	PREV
+	DW	ATT
+	DW	EQUAL
+	DW	OVER
+	DW	LIT,BBUF0+6
+	DW	PLUS
+	DW	CAT
+	DW	ORR
+	DW	ZBRAN,BUFFE2-$	; WHILE
+	DW	ZERO
+	DW	SWAP
+	DW	LIT,BBUF0+6
+	DW	PLUS
+	DW	CSTOR		;  ( second chance )
+	DW	USE
+	DW	ATT
+	DW	PBUF
+	DW	DROP
+	DW	USE
+	DW	STORE
+	DW	BRAN,BUFFE1-$	; REPEAT
+BUFFE2	DW	DUPE
 	DW	TOR
-				; BEGIN
-BUFFE1	DW	PBUF
-	DW	ZBRAN,BUFFE1-$	; UNTIL
+	DW	PBUF
+	DW	DROP
 	DW	USE
 	DW	STORE
 	DW	RAT
 	DW	ATT
 	DW	ZLESS
-	DW	ZBRAN,BUFFE2-$	; IF
+	DW	ZBRAN,BUFFE3-$	; IF
 	DW	RAT
-	DW	TWOP
+	DW	WRUN
+				; THEN
+BUFFE3	DW	RAT
+	DW	BLINK
 	DW	RAT
-	DW	ATT
-	DW	LIT,7FFFH
-	DW	ANDD
+	DW	PREV
+	DW	STORE
+	DW	FROMR
+	DW	TWOP
+	DW	SEMIS
+;
+; ( n --- a )
+	DB	85H,'BLOC','K'+80H
+	DW	BUFFE-9
+BLOCK	DW	DOCOL
 	DW	ZERO
-	DW	RSLW
-				; THEN
-BUFFE2	DW	RAT
+	DW	LIT,PINL
 	DW	STORE
+	DW	OFSET
+	DW	ATT
+	DW	PLUS
+	DW	TOR
+	DW	PREV
+	DW	ATT
+	DW	DUPE
+	DW	ATT
+	DW	RAT
+	DW	SUBB
+	DW	TWOS
+	DW	ZBRAN,BLOCK1-$	; IF
+	DW	DROP
+	DW	RAT
+	DW	BFIND
+	DW	QDUP
+	DW	ZEQU
+	DW	ZBRAN,BLOCK2-$	;  IF
+	DW	RAT
+	DW	BUFFE
+	DW	DUPE
 	DW	RAT
+	DW	ONE
+	DW	RSLW
+	DW	TWOM
+				;  THEN
+BLOCK2	DW	DUPE
 	DW	PREV
 	DW	STORE
+				; THEN
+BLOCK1	DW	FROMR
+	DW	DROP
+	DW	TWOP
+	DW	SEMIS
+;
+; ( n1 --- n2 a ; Take n2 ( at most n1 ) adjoining buffers from USE. )
+; The referenced buffers on the way get the second chance
+; as in BUFFER. The run stops at PREV, a referenced buffer or LIMIT.
+	DB	86H,'(TAKE',')'+80H
+	DW	BLOCK-8
+TAKE	DW	DOCOL
+	DW	USE
+	DW	ATT
+				; BEGIN
+TAKE1	DW	DUPE
+	DW	PREV
+	DW	ATT
+	DW	EQUAL
+	DW	OVER
+	DW	LIT,BBUF0+6
+	DW	PLUS
+	DW	CAT
+	DW	ORR
+	DW	ZBRAN,TAKE2-$	; WHILE
+	DW	ZERO
+	DW	OVER
+	DW	LIT,BBUF0+6
+	DW	PLUS
+	DW	CSTOR		;  ( second chance )
+	DW	PBUF
+	DW	DROP
+	DW	BRAN,TAKE1-$	; REPEAT
+TAKE2	DW	TOR
+	DW	ONE
+				; BEGIN
+TAKE3	DW	TDUP
+	DW	GREAT
+	DW	ZBRAN,TAKE4-$	;  IF
+	DW	DUPE
+	DW	BFLEN
+	DW	STAR
+	DW	RAT
+	DW	PLUS
+	DW	DUPE
+	DW	LIMIT
+	DW	EQUAL
+	DW	OVER
+	DW	PREV
+	DW	ATT
+	DW	EQUAL
+	DW	ORR
+	DW	SWAP
+	DW	LIT,BBUF0+6
+	DW	PLUS
+	DW	CAT
+	DW	ORR
+	DW	ZEQU
+	DW	BRAN,TAKE5-$	;  ELSE
+TAKE4	DW	ZERO
+				;  THEN
+TAKE5	DW	ZBRAN,TAKE6-$	; WHILE
+	DW	ONEP
+	DW	BRAN,TAKE3-$	; REPEAT
+TAKE6	DW	SWAP
+	DW	DROP
 	DW	FROMR
-	DW	TWOP
 	DW	SEMIS
 ;
-; ( n --- a )
-	DB	85H,'BLOC','K'+80H
-	DW	BUFFE-9
-BLOCK	DW	DOCOL
+; ( n1 n2 --- ; Read ahead the blocks n1, n1+1, ..., n1+n2-1. )
+; Only the blocks not in the buffers from n1 on are read
+; ( at most #BUFF/2, and as many as (TAKE) gives ) with one transfer.
+	DB	8AH,'(PREFETCH',')'+80H
+	DW	TAKE-9
+PFETCH	DW	DOCOL
+	DW	NUMBUF
+	DW	TDIV
+	DW	MIN
+	DW	SWAP
 	DW	OFSET
 	DW	ATT
 	DW	PLUS
-	DW	TOR
-	DW	PREV
-	DW	ATT
+	DW	SWAP
+	DW	TDUP
+	DW	PINND
+	DW	ZBRAN,PFETCC-$	; IF
+	DW	UNPIN
+				; THEN
+PFETCC	DW	ZERO
+	DW	SWAP
+	DW	ZERO
+	DW	XDO		; DO
+PFETC1	DW	TDUP
+	DW	PLUS
+	DW	BFIND
+	DW	ZBRAN,PFETC2-$	;  IF
+	DW	LLEAVE
+	DW	BRAN,PFETC3-$	;  ELSE
+PFETC2	DW	ONEP
+				;  THEN
+PFETC3	DW	XLOOP,PFETC1-$	; LOOP
+	DW	QDUP
+	DW	ZBRAN,PFETC4-$	; IF
+	DW	TAKE		;  n1 n a
+	DW	OVER
+	DW	ZERO
+	DW	XDO		;  DO
+PFETC5	DW	DUPE		;   ( Write back. )
+	DW	IDO
+	DW	BFLEN
+	DW	STAR
+	DW	PLUS
 	DW	DUPE
 	DW	ATT
-	DW	RAT
-	DW	SUBB
-	DW	TWOS
-	DW	ZBRAN,BLOCK1-$	; IF
-				;  BEGIN
-BLOCK2	DW	PBUF
-	DW	ZEQU
-	DW	ZBRAN,BLOCK3-$	;   IF
-	DW	DROP
-	DW	RAT
-	DW	BUFFE
+	DW	ZLESS
+	DW	ZBRAN,PFETC6-$	;   IF
 	DW	DUPE
-	DW	RAT
-	DW	ONE
-	DW	RSLW
-	DW	TWOM
+	DW	WRUN
 				;   THEN
-BLOCK3	DW	DUPE
-	DW	ATT
-	DW	RAT
-	DW	SUBB
-	DW	TWOS
-	DW	ZEQU
-	DW	ZBRAN,BLOCK2-$	;  UNTIL
+PFETC6	DW	DROP
+	DW	XLOOP,PFETC5-$	;  LOOP
+	DW	OVER
+	DW	ZERO
+	DW	XDO		;  DO
+PFETC7	DW	DUPE		;   ( Rechain. )
+	DW	IDO
+	DW	BFLEN
+	DW	STAR
+	DW	PLUS
+	DW	ZERO
+	DW	OVER
+	DW	LIT,BBUF0+6
+	DW	PLUS
+	DW	CSTOR
+	DW	LIT,4
+	DW	PICK
+	DW	IDO
+	DW	PLUS
+	DW	SWAP
+	DW	BLINK
+	DW	XLOOP,PFETC7-$	;  LOOP
+	DW	OVER
+	DW	BFLEN
+	DW	STAR
+	DW	OVER
+	DW	PLUS
 	DW	DUPE
-	DW	PREV
-	DW	STORE
-				; THEN
-BLOCK1	DW	FROMR
+	DW	LIMIT
+	DW	EQUAL
+	DW	ZBRAN,PFETC8-$	;  IF
 	DW	DROP
+	DW	FIRST
+				;  THEN
+PFETC8	DW	USE
+	DW	STORE
+	DW	ROT
+	DW	LIT,DRSIZ
+	DW	BSCR
+	DW	STAR
+	DW	SLMOD		;  n a n3 drv
+	DW	THREE
+	DW	PICK
 	DW	TWOP
-	DW	SEMIS
+	DW	ROT
+	DW	LIT,5
+	DW	PICK
+	DW	RDBUFS
+	DW	ZBRAN,PFETC9-$	;  IF
+	DW	SWAP		;   ( Discard them. )
+	DW	ZERO
+	DW	XDO		;   DO
+PFETCA	DW	LIT,7FFFH
+	DW	OVER
+	DW	IDO
+	DW	BFLEN
+	DW	STAR
+	DW	PLUS
+	DW	BLINK
+	DW	XLOOP,PFETCA-$	;   LOOP
+	DW	DUPE
+				;  THEN
+PFETC9	DW	TDROP
+	DW	BRAN,PFETCB-$	; ELSE
+PFETC4	DW	DROP
+				; THEN
+PFETCB	DW	SEMIS
 ;
 ; ( --- )
 	DB	89H,'INTERPRE','T'+80H
-	DW	BLOCK-8
+	DW	PFETCH-13
 INTER	DW	DOCOL
 				; BEGIN
-INTER1	DW	FIND
+INTER1	DW	BLS
+	DW	WORDS
+	IF	LITFS0
+	DW	DUPE
+	DW	QDIGS
+	DW	ZBRAN,INTER8-$	;  IF
+	DW	DROP
+	DW	ZERO		;   ( not searched )
+	DW	BRAN,INTER9-$	;  ELSE
+INTER8	DW	SRCH
+				;  THEN
+INTER9	DW	QDUP
+	ENDIF
+	IF	NOT LITFS0
+	DW	SRCH
 	DW	QDUP
+	ENDIF
 	DW	ZBRAN,INTER2-$	;  IF
 	DW	DUPE
 	DW	TWOP
@@ -3613,11 +6541,21 @@ INTER1	DW	FIND
 	DW	ATT
 	DW	LESS
 	DW	ZBRAN,INTER4-$	;   IF
+	IF	NATIV0 OR FUSE0
+	DW	NCOMP
+	ENDIF
+	IF	NOT (NATIV0 OR FUSE0)
 	DW	COMMA
+	ENDIF
 	DW	BRAN,INTER5-$	;   ELSE
 INTER4	DW	EXEC
 				;   THEN
+	IF	QSTK0
+INTER5	DW	PQSTK
+	ENDIF
+	IF	NOT QSTK0
 INTER5	DW	QSTAC
+	ENDIF
 	DW	BRAN,INTER3-$	;  ELSE
 INTER2	DW	HERE
 	DW	NUMB
@@ -3630,7 +6568,12 @@ INTER2	DW	HERE
 INTER6	DW	DROP
 	DW	LITER		;    [COMPILE] LITERAL
 				;   THEN
+	IF	QSTK0
+INTER7	DW	PQSTK
+	ENDIF
+	IF	NOT QSTK0
 INTER7	DW	QSTAC
+	ENDIF
 				;  THEN
 INTER3	DW	BRAN,INTER1-$	; AGAIN
 ;
@@ -3779,6 +6722,10 @@ LOAD	DW	DOCOL
 	DW	STAR
 	DW	BLK
 	DW	STORE
+	DW	BLK
+	DW	ATT
+	DW	BSCR
+	DW	PFETCH
 	DW	INTER
 	DW	FROMR
 	DW	INN
@@ -3804,6 +6751,10 @@ ARROW	DW	DOCOL
 	DW	SUBB
 	DW	BLK
 	DW	PSTOR
+	DW	BLK
+	DW	ATT
+	DW	BSCR
+	DW	PFETCH
 	DW	SEMIS
 ;
 ; ( nfa --- )
@@ -3848,7 +6799,24 @@ PCREAT	DW	DOCOL
 	DW	LIT,4H
 	DW	MESS
 				; THEN
-PCREA1	DW	HERE
+PCREA1	EQU	$
+	IF	HASHED
+	DW	HERE		; Make room for the index node.
+	DW	DUPE
+	DW	LIT,4
+	DW	PLUS
+	DW	LIT,MXTOKN+1
+	DW	LCMOVE
+	DW	HERE
+	DW	LIT,4
+	DW	PLUS
+	DW	CURR
+	DW	ATT
+	DW	HLINK
+	DW	LIT,4
+	DW	ALLOT
+	ENDIF
+	DW	HERE
 	DW	DUPE
 	DW	CAT
 	DW	WYDTH
@@ -3916,6 +6884,11 @@ ASSEM	DW	DOVOC
 	DW	0A081H		; "blank" word (= 81H,' '+80H)
 	DW	STAN79-14
 	DW	FORTH+6
+	IF	HASHED
+	DW	FORTH+4		; parent vocabulary
+	DW	STAN79-14	; ( only the kernel words visible )
+	DS	NHASH0*2	; buckets
+	ENDIF
 ;
 ; ( --- ) <name>
 	DB	84H,'COD','E'+80H
@@ -4000,10 +6973,315 @@ LIST1	DW	CR
 	DW	STORE
 	DW	SEMIS
 ;
+; ( --- ) <filename>
+; Save the dictionary up to HERE and the user variables as
+; a .COM file, which starts with this dictionary by COLD.
+	DB	8BH,'SAVE-SYSTE','M'+80H
+	DW	LIST-7
+SVSYS	DW	DOCOL
+	DW	BLS
+	DW	WORDS
+	DW	DUPE
+	DW	ONEP
+	DW	CAT
+	DW	ZEQU		; ( no name )
+	DW	ZERO
+	DW	QERR
+	DW	SETFCB
+	DW	UPP		; WIDTH WARNING FENCE DP VOC-LINK
+	DW	LIT,0CH
+	DW	PLUS
+	DW	LIT,UVR+0CH
+	DW	LIT,0AH
+	DW	CMOVEE
+	DW	UPP		; CONTEXT CURRENT
+	DW	LIT,20H
+	DW	PLUS
+	DW	LIT,UVR+20H
+	DW	LIT,4
+	DW	CMOVEE
+	DW	ORIGI
+	DW	HERE
+	DW	SAVE
+	DW	LIT,9H		; ( error #9 )
+	DW	QERR
+	DW	SEMIS
+;
+	IF	PROF0
+;
+; NEXT1 while PROFILE is on ( JMP PROFN is patched at NEXT1 )
+; Each entry of the table is 8 bytes:
+;	[cfa] [count (high)] [count (low)] [unused]
+PROFN:	PUSH	B	; save IP
+	PUSH	H	; save cfa
+	XCHG		; DE <- cfa
+	MOV	H,D
+	MOV	L,E
+	DAD	H
+	DAD	H	; HL <- cfa * 4
+	MVI	A,8	; ( probes at most )
+	STA	PPRB
+	; HL <- the entry at PBASE + ( HL & PMASK )
+PROFN1:	LDA	PMASK
+	ANA	L
+	MOV	C,A
+	LDA	PMASK+1
+	ANA	H
+	MOV	B,A
+	LHLD	PBASE
+	DAD	B
+	; if the entry is of the cfa then count it
+	MOV	A,M
+	INX	H
+	CMP	E
+	JNZ	PROFN2
+	MOV	A,M
+	CMP	D
+	JZ	PROFN4
+	; if the entry is empty then take it
+PROFN2:	MOV	A,M
+	DCX	H
+	ORA	M
+	JNZ	PROFN3
+	MOV	M,E
+	INX	H
+	MOV	M,D
+	JMP	PROFN4
+	; the next entry
+PROFN3:	LXI	H,PPRB
+	DCR	M
+	JZ	PROFN5	; ( not counted )
+	LXI	H,8
+	DAD	B
+	JMP	PROFN1
+	; count + 1
+PROFN4:	INX	H
+	INX	H
+	INX	H
+	INR	M	; ( low )
+	JNZ	PROFN5
+	INX	H
+	INR	M
+	JNZ	PROFN5
+	DCX	H
+	DCX	H
+	DCX	H
+	INR	M	; ( high )
+	JNZ	PROFN5
+	INX	H
+	INR	M
+PROFN5:	POP	H	; restore cfa
+	POP	B	; restore IP
+	MOV	E,M
+	INX	H
+	MOV	D,M
+	XCHG
+	PCHL
+;
+PBASE	DW	0	; the table of PROFILE
+PMASK	DW	0	; the table size - 8
+PPRB	DB	0	; probe counter
+PTOP	DW	0	; (the entry and the count found by (PMAX))
+PTOPC	DW	0,0
+;
+; ( a n --- ; Count the calls per CFA into the table a of
+;             n bytes ( rounded down to 8 * 2^k ), or stop counting
+;             if n < 8. The table is kept until the next PROFILE. )
+	DB	87H,'PROFIL','E'+80H
+	DW	SVSYS-14
+PROF	DW	$+2
+	; stop counting ( restore NEXT1 )
+	MVI	A,5EH	; "MOV E,M"
+	STA	NEXT1
+	LXI	H,5623H	; "INX H", "MOV D,M"
+	SHLD	NEXT1+1
+	POP	D	; DE <- n
+	POP	H	; HL <- a
+	MOV	A,E
+	SUI	8
+	MOV	A,D
+	SBI	0
+	JC	NEXT	; ( n < 8 )
+	SHLD	PBASE
+	; HL <- the largest 8 * 2^k <= n
+	LXI	H,8
+PROF1:	PUSH	H
+	DAD	H
+	JC	PROF2
+	MOV	A,E
+	SUB	L
+	MOV	A,D
+	SBB	H
+	JC	PROF2
+	POP	PSW	; ( drop )
+	JMP	PROF1
+PROF2:	POP	H
+	; PMASK <- HL - 8
+	PUSH	H
+	LXI	D,-8
+	DAD	D
+	SHLD	PMASK
+	POP	D	; DE <- table size
+	; clear the table
+	LHLD	PBASE
+PROF3:	MVI	M,0
+	INX	H
+	DCX	D
+	MOV	A,D
+	ORA	E
+	JNZ	PROF3
+	; start counting ( NEXT1 <- "JMP PROFN" )
+	MVI	A,0C3H	; "JMP"
+	STA	NEXT1
+	LXI	H,PROFN
+	SHLD	NEXT1+1
+	JMP	NEXT
+;
+; ( --- a / ff ; a: the entry of the most calls in the PROFILE table )
+	DB	86H,'(PMAX',')'+80H
+	DW	PROF-10
+PMAX	DW	$+2
+	LHLD	PBASE
+	MOV	A,H
+	ORA	L
+	JZ	HPUSH	; ( no table )
+	PUSH	B	; save IP
+	LXI	H,0
+	SHLD	PTOP
+	SHLD	PTOPC
+	SHLD	PTOPC+2
+	LHLD	PMASK
+	LXI	D,8
+	DAD	D
+	MOV	B,H
+	MOV	C,L	; BC <- table size
+	LHLD	PBASE
+	; if the count > PTOPC then take the entry
+PMAX1:	PUSH	H	; save entry
+	LXI	D,4
+	DAD	D
+	LDA	PTOPC+2
+	SUB	M
+	INX	H
+	LDA	PTOPC+3
+	SBB	M
+	DCX	H
+	DCX	H
+	DCX	H
+	LDA	PTOPC
+	SBB	M
+	INX	H
+	LDA	PTOPC+1
+	SBB	M
+	POP	H	; restore entry
+	JNC	PMAX2
+	SHLD	PTOP
+	PUSH	H
+	INX	H
+	INX	H
+	MOV	E,M
+	INX	H
+	MOV	D,M
+	XCHG
+	SHLD	PTOPC
+	XCHG
+	INX	H
+	MOV	E,M
+	INX	H
+	MOV	D,M
+	XCHG
+	SHLD	PTOPC+2
+	POP	H
+	; the next entry
+PMAX2:	LXI	D,8
+	DAD	D
+	MOV	A,C
+	SUI	8
+	MOV	C,A
+	MOV	A,B
+	SBI	0
+	MOV	B,A
+	ORA	C
+	JNZ	PMAX1
+	POP	B	; restore IP
+	LHLD	PTOP
+	JMP	HPUSH
+;
+; ( n --- ; Stop PROFILE and print the n words of the most calls
+;           with the counts. ( The counts printed are cleared. ) )
+	DB	88H,'.PROFIL','E'+80H
+	DW	PMAX-9
+DPROF	DW	DOCOL
+	DW	ZERO
+	DW	ZERO
+	DW	PROF
+	DW	ZERO
+	DW	XDO		; DO
+DPROF1	DW	PMAX
+	DW	QDUP
+	DW	ZBRAN,DPROF2-$	;  IF
+	DW	CR
+	DW	DUPE
+	DW	TWOP
+	DW	TAT
+	DW	LIT,10
+	DW	DDOTR		;   count
+	DW	DUPE
+	DW	ATT
+	DW	ZERO
+	DW	LIT,7
+	DW	DDOTR		;   cfa
+	DW	SPACE
+	DW	DUPE
+	DW	ATT
+	DW	TWOP
+	DW	DUPE
+	DW	NFA
+	DW	DUPE		;   ( A real name field ends just
+	DW	CAT		;     before the link field, with the
+	DW	LIT,1FH		;     last character of bit 7 set. )
+	DW	ANDD
+	DW	WYDTH
+	DW	ATT
+	DW	MIN
+	DW	OVER
+	DW	PLUS
+	DW	ROT
+	DW	LIT,5H
+	DW	SUBB
+	DW	OVER
+	DW	EQUAL
+	DW	SWAP
+	DW	CAT
+	DW	LIT,07FH
+	DW	SWAP
+	DW	LESS
+	DW	ANDD
+	DW	ZBRAN,DPROF4-$	;   IF
+	DW	IDDOT		;    name
+	DW	BRAN,DPROF5-$	;   ELSE
+DPROF4	DW	DROP		;    ( headerless )
+				;   THEN
+DPROF5	DW	TWOP
+	DW	LIT,4
+	DW	ERASE
+	DW	BRAN,DPROF3-$	;  ELSE
+DPROF2	DW	LLEAVE
+				;  THEN
+DPROF3	DW	XLOOP,DPROF1-$	; LOOP
+	DW	SEMIS
+;
+BYEL	EQU	DPROF-11
+	ENDIF
+	IF	NOT PROF0
+BYEL	EQU	SVSYS-14
+	ENDIF
+;
 ; ( --- ; Exit FORTH. )
 	DB	83H,'BY','E'+80H
-	DW	LIST-7
+	DW	BYEL
 BYE	DW	$+2
+	CALL	OFLSH
 	LXI	D,WBOOT
 	CALL	IOS
 ;
@@ -20,11 +20,12 @@
 /*                                                                  */
 /********************************************************************/
 //
-// 動作のあらまし : .d88 形式の CP/M ディスクイメージ内末尾の空き領域に、
+// 動作のあらまし : .d88 形式の CP/M ディスクイメージ内の空き領域に、
 //                テキストファイルおよびバイナリデータを書き込む。
-//                したがって、断片化した空き領域はすべて無視する。
-//                ファイルは一つずつしか書き込めない。
+//                使用中の data block の表を作り、空き領域に（なるべく連続して）置く。
+//                一度の起動で複数のファイルを書き込める（ディレクトリの走査は最初の一回だけ）。
 //                同名ファイルがあったときは書き込みを行わない。
+//                イメージ全体を一度だけメモリに読み込み、変更したセクタだけを最後に書き戻す。
 //                コマンドライン引数なしで普通に起動すると、使い方の簡単な説明が出る。
 //
 //
@@ -66,7 +67,7 @@
 // 5 inch 標準・両面ディスク : 256 bytes / 1 sector,
 //                          32 sectors / 1 track,
 //                          40 tracks / 1 disk.
-// （ただし、このプログラムでは、8 inch のほうしか扱わない）
+// （どちらを扱うかは -f で選ぶ。指定がなければ .d88 のヘッダーから判別する）
 //
 // テキストデータの場合、128 バイトごとに区切ったとき足りない部分が出ることがあるが、
 // そこには 1A を埋める。
@@ -75,64 +76,419 @@
 //
 //
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 
-#define DATA_BLOCK_SIZE 2048
-#define BPS 256   // bytes per sector
-#define SPT 32    // sectors per track
-#define TRACKS 40 // number of all tracks
-#define RPD 16    // records per data blocks
+char *image_filename;
+char *cpm_filename;
+int replace; // 同じ名前のファイルがあるとき、置き換える
+FILE *msg; // 経過やエラーの表示先。取り出したファイルを標準出力に書くときは stderr にする。
+
+/* ディスクの形式 (disk parameter block) */
+// 以前はコンパイル時のマクロで 5 inch ミニ・両面ディスクに固定していたが、
+// 起動時に -f で選ぶか、.d88 のヘッダーから自動判別する。
+struct disk_format
+{
+  const char *name;
+  int bps;        // bytes per sector
+  int spt;        // sectors per track
+  int tracks;     // number of all tracks
+  int off;        // number of system tracks (data block 0 番はその直後から始まる)
+  int bls;        // bytes per data block
+  int dir_blocks; // number of data blocks for the directory
+  int skew;       // sector skew (0 = なし)
+};
+
+const struct disk_format formats[] = {
+    {"2d", 256, 32, 40, 2, 2048, 2, 0},   // PC-8801 (XM8) 5 inch 2D
+    {"8inch", 128, 26, 77, 2, 1024, 2, 6}, // CP/M 2.2 標準 8 inch 片面
+    {NULL, 0, 0, 0, 0, 0, 0, 0}};
+
+struct disk_format fmt;
+#define D88_TRACKS 164 // .d88 のトラック・テーブルの項目数
+int RPD;                // records per data blocks
+int num_of_FCBs;        // 2d では 128
+int num_of_data_blocks; // 2d では 152
+int num_of_sectors;     // 2d では 1280
+int blocks_per_FCB;     // FCB の a0 ~ aF に入る data block の数 (16 または 8)
+int records_per_FCB;    // FCB 一つで扱えるレコードの数
+int extents_per_FCB;    // FCB 一つで扱える 16k バイト単位の extend の数 (EXM + 1)
+
+/* select_format(name) */
+// name で指定した形式を fmt に設定する。
+// name が "bps,spt,tracks,off,bls,dir_blocks[,skew]" の形なら、その値をそのまま使う。
+int select_format(const char *name)
+{
+  int i;
+  long blocks;
+
+  for (i = 0; formats[i].name != NULL; i++)
+    if (strcmp(formats[i].name, name) == 0)
+    {
+      fmt = formats[i];
+      return 1;
+    }
+
+  memset(&fmt, 0, sizeof(fmt));
+  fmt.name = name;
+  if (sscanf(name, "%d,%d,%d,%d,%d,%d,%d", &fmt.bps, &fmt.spt, &fmt.tracks, &fmt.off, &fmt.bls, &fmt.dir_blocks, &fmt.skew) < 6)
+  {
+    fprintf(msg, "Unknown disk format %s.\n", name);
+    return 0;
+  }
+
+  // 表の大きさや位置の計算に使う値なので、範囲外のものは受け付けない。
+  // ディレクトリの data block は、データ・エリアの中に収まっていなければならない。
+  // data block の番号は 16 ビットなので 65536 個まで。
+  // 256 個を超えるディスクでは FCB が 8 block しか持てないので、1024 バイトの block では
+  // FCB 一つが 16k バイトに満たず EXM が作れない。CP/M もこの組み合わせは許さない。
+  if (fmt.bps < 128 || fmt.bps > 8192 || fmt.bps % 128 != 0 ||
+      fmt.spt <= 0 || fmt.spt > 256 ||
+      fmt.tracks <= 0 || fmt.tracks > D88_TRACKS ||
+      fmt.off < 0 || fmt.off >= fmt.tracks ||
+      fmt.bls < 1024 || fmt.bls > 16384 || fmt.bls % fmt.bps != 0 ||
+      fmt.skew < 0 || fmt.skew >= fmt.spt)
+  {
+    fprintf(msg, "Invalid disk format %s.\n", name);
+    return 0;
+  }
+  blocks = (long)fmt.bps * fmt.spt * (fmt.tracks - fmt.off) / fmt.bls;
+  if (blocks > 65536 || (fmt.bls == 1024 && blocks > 256) ||
+      fmt.dir_blocks <= 0 || fmt.dir_blocks >= blocks)
+  {
+    fprintf(msg, "Invalid disk format %s.\n", name);
+    return 0;
+  }
+  return 1;
+}
+
+/* detect_format() */
+// .d88 ヘッダーのメディアの種類 (1BH) と、最初のセクタの大きさ・トラック当たりのセクタ数から形式を推定する。
+int detect_format(const unsigned char *header, long size)
+{
+  long track0 = header[0x20] | header[0x21] << 8 | (long)header[0x22] << 16 | (long)header[0x23] << 24;
+
+  if (size >= track0 + 16)
+  {
+    const unsigned char *sector = header + track0;
+    int n = sector[3];
+    int nsec = sector[4] | sector[5] << 8;
+
+    if (header[0x1B] == 0x00 && n == 1 && nsec == 16)
+      return select_format("2d");
+    if (n == 0 && nsec == 26)
+      return select_format("8inch");
+  }
+
+  fprintf(msg, "Cannot detect the disk format of %s. Use -f.\n", image_filename);
+  return 0;
+}
+
+/* .d88 ファイルの構造 */
+// 先頭 20H バイトはディスク名などのヘッダーで、その直後に 164 個のトラック・テーブルが続く。
+// トラック・テーブルの各項目は、そのトラックの先頭のファイル上の位置 (4 bytes, 0 = トラックなし)。
+// トラックの中では、セクタごとに 16 バイトのヘッダーのあとにデータが続く。
+// セクタ・ヘッダー : |C|H|R|N|セクタ数 (2 bytes)|密度|削除|状態|予約 (5 bytes)|データの大きさ (2 bytes)|
+// セクタはトラックの中で R の順に並んでいるとは限らず、大きさもセクタごとに違ってよい。
+// トラック・テーブルの項目数 D88_TRACKS は、形式の定義の前に置いてある。
+
+/* index_d88(d88, size, offset, sectors) */
+// トラック・テーブルを一度だけ読み、すべてのセクタのデータ位置を物理的な順番で offset に書き出す。
+// 物理的な順番とは、トラック・テーブルの順に、各トラックの中では R の小さい順に並べたもの。
+// 全部で何セクタあったかを返す。大きさが fmt.bps でないセクタがあれば -1 を返す。
+int index_d88(const unsigned char *d88, long size, long *offset, int sectors)
+{
+  long first = d88[0x20] | d88[0x21] << 8 | (long)d88[0x22] << 16 | (long)d88[0x23] << 24;
+  int tracks = first > 0x20 && (first - 0x20) / 4 < D88_TRACKS ? (first - 0x20) / 4 : D88_TRACKS;
+  int t, i, j, n = 0;
+
+  for (t = 0; t < tracks && n < sectors; t++)
+  {
+    const unsigned char *entry = d88 + 0x20 + 4 * t;
+    long p = entry[0] | entry[1] << 8 | (long)entry[2] << 16 | (long)entry[3] << 24;
+    if (p == 0 || p + 16 > size)
+      continue;
+
+    int nsec = d88[p + 4] | d88[p + 5] << 8;
+    int head = n;
+    for (i = 0; i < nsec && n < sectors && p + 16 <= size; i++)
+    {
+      int length = d88[p + 14] | d88[p + 15] << 8;
+      if (length != fmt.bps || p + 16 + length > size)
+        return -1;
+
+      // R の順に挿入する
+      for (j = n; j > head && d88[offset[j - 1] - 16 + 2] > d88[p + 2]; j--)
+        offset[j] = offset[j - 1];
+      offset[j] = p + 16;
+      n++;
+      p += 16 + length;
+    }
+  }
+
+  return n;
+}
+
+/* set_geometry(d88, size) */
+// fmt から、ほかの大きさと、セクタ番号 → .d88 ファイル上の位置 の表を作る。
+// 以後、レコードの位置はこの表を一度引くだけで求まる。
+long *sector_offset = NULL;
+
+int set_geometry(const unsigned char *d88, long size)
+{
+  int t, i, pos;
+  char *used = calloc(fmt.spt, 1);
+  int *xlt = malloc(sizeof(int) * fmt.spt);
+
+  RPD = fmt.bls / 128;
+  num_of_FCBs = fmt.dir_blocks * fmt.bls / 32;
+  num_of_data_blocks = fmt.bps * fmt.spt * (fmt.tracks - fmt.off) / fmt.bls;
+  num_of_sectors = fmt.spt * fmt.tracks;
+  blocks_per_FCB = num_of_data_blocks > 256 ? 8 : 16; // 256 個を超えると a0 ~ aF は 2 バイトずつになる
+  records_per_FCB = blocks_per_FCB * RPD;
+  extents_per_FCB = records_per_FCB / 128;
+
+  // セクタ・スキュー（論理セクタ i → 物理セクタ xlt[i]）
+  for (i = 0, pos = 0; i < fmt.spt; i++)
+  {
+    while (used[pos])
+      pos = (pos + 1) % fmt.spt;
+    xlt[i] = fmt.skew ? pos : i;
+    used[pos] = 1;
+    pos = (pos + fmt.skew) % fmt.spt;
+  }
+  free(used);
+
+  long *physical = malloc(sizeof(long) * num_of_sectors);
+  int found = index_d88(d88, size, physical, num_of_sectors);
+  if (found < 0)
+  {
+    fprintf(msg, "%s has sectors of other than %d bytes.\n", image_filename, fmt.bps);
+    free(physical);
+    free(xlt);
+    return 0;
+  }
+  if (found < num_of_sectors)
+  {
+    fprintf(msg, "%s is too small for a CP/M disk image.\n", image_filename);
+    free(physical);
+    free(xlt);
+    return 0;
+  }
+
+  // システム・トラックにはスキューをかけない
+  sector_offset = malloc(sizeof(long) * num_of_sectors);
+  for (t = 0; t < fmt.tracks; t++)
+    for (i = 0; i < fmt.spt; i++)
+      sector_offset[t * fmt.spt + i] = physical[t * fmt.spt + (t < fmt.off ? i : xlt[i])];
+  free(physical);
+  free(xlt);
+  return 1;
+}
 
 /* convert_addr(addr) */
 // address on a disk --> address on a .d88 file
-// PC-8801 のエミュレータ用の .d88 ファイルのデータは、
-// 256 バイトごとに 16 バイト長のヘッダーのようなものがついている。
-// 注意点として、全体の先頭にはさらに 43 行の .d88 専用領域が付いている。
-int convert_addr(int addr)
+long convert_addr(long addr)
 {
-  return 43 * 16 + 16 + addr + 16 * (addr / 256);
+  return sector_offset[addr / fmt.bps] + addr % fmt.bps;
 }
 
-char *image_filename;
-char *cpm_filename;
-char FCB_buff[32];
-char record_buff[128];
-const int num_of_FCBs = DATA_BLOCK_SIZE * 2 / 32;                          // = 128
-const int num_of_data_blocks = BPS * SPT * (TRACKS - 2) / DATA_BLOCK_SIZE; // = 152
+unsigned char FCB_buff[32];
+unsigned char record_buff[128];
+
+/* ディスクイメージのバッファ */
+// .d88 ファイル全体を一度だけ読み込み、FCB とレコードの読み書きはすべてメモリ上で行う。
+// 書き換えたセクタには dirty の印をつけておき、最後に flush_image() でまとめて書き戻す。
+unsigned char *image = NULL;
+long image_size = 0;
+char *dirty = NULL;
+
+/* load_image() */
+// .d88 ファイルを丸ごと image に読み込む。失敗したら 0 を返す。
+// 形式が指定されていなければ (fmt.name == NULL)、ヘッダーから判別する。
+int load_image()
+{
+  FILE *fp = fopen(image_filename, "rb");
+  if (fp == NULL)
+  {
+    fprintf(msg, "Cannot open %s.\n", image_filename);
+    return 0;
+  }
+
+  fseek(fp, 0, SEEK_END);
+  image_size = ftell(fp);
+  fseek(fp, 0, SEEK_SET);
+  if (image_size < 0x20 + 4)
+  {
+    fprintf(msg, "%s is too small for a .d88 file.\n", image_filename);
+    fclose(fp);
+    return 0;
+  }
+
+  image = malloc(image_size);
+  if (image == NULL || fread(image, 1, image_size, fp) != (size_t)image_size)
+  {
+    fprintf(msg, "Cannot read %s.\n", image_filename);
+    fclose(fp);
+    return 0;
+  }
+  fclose(fp);
+
+  if (fmt.name == NULL && !detect_format(image, image_size))
+    return 0;
+  if (!set_geometry(image, image_size))
+    return 0;
+
+  dirty = calloc(num_of_sectors, 1);
+  return 1;
+}
+
+/* flush_image() */
+// dirty なセクタだけを、.d88 ファイルの先頭から順に一回の走査で書き戻す。
+// ファイル上で隣り合う dirty なセクタは、間の 16 バイトのセクタ・ヘッダーごと一度の fwrite にまとめる
+// （ヘッダーはメモリ上でも変更していないので、同じ内容が書かれるだけである）。
+int compare_offset(const void *a, const void *b)
+{
+  long x = sector_offset[*(const int *)a];
+  long y = sector_offset[*(const int *)b];
+  return x < y ? -1 : x > y;
+}
+
+int flush_image()
+{
+  FILE *fp = NULL;
+  int *list = malloc(sizeof(int) * num_of_sectors);
+  int n = 0, i, j;
+
+  for (i = 0; i < num_of_sectors; i++)
+    if (dirty[i])
+      list[n++] = i;
+  qsort(list, n, sizeof(int), compare_offset);
+
+  for (i = 0; i < n; i = j + 1)
+  {
+    for (j = i; j + 1 < n && sector_offset[list[j + 1]] == sector_offset[list[j]] + 16 + fmt.bps; j++)
+      ;
+
+    if (fp == NULL && (fp = fopen(image_filename, "r+b")) == NULL) // 部分的な上書きができないといけない。
+    {
+      fprintf(msg, "Cannot write %s.\n", image_filename);
+      free(list);
+      return 0;
+    }
+    long head = sector_offset[list[i]];
+    long tail = sector_offset[list[j]] + fmt.bps;
+    if (fseek(fp, head, SEEK_SET) != 0 || fwrite(image + head, 1, tail - head, fp) != (size_t)(tail - head))
+    {
+      fprintf(msg, "Cannot write %s.\n", image_filename);
+      fclose(fp);
+      free(list);
+      return 0;
+    }
+  }
+
+  // ディスクが一杯のときなどは、fflush() や fclose() で初めて失敗がわかることがある。
+  if (fp != NULL)
+  {
+    int error = fflush(fp) != 0;
+    if (fclose(fp) != 0)
+      error = 1;
+    if (error)
+    {
+      fprintf(msg, "Cannot write %s.\n", image_filename);
+      free(list);
+      return 0;
+    }
+  }
+  free(list);
+  memset(dirty, 0, num_of_sectors);
+  return 1;
+}
+
+/* read_image(addr, buf, len), write_image(addr, buf, len) */
+// ディスク上のアドレス addr から len バイトを読み書きする。
+// FCB (32 bytes) もレコード (128 bytes) もセクタをまたがないので、一回の memcpy で済む。
+void read_image(long addr, unsigned char *buf, int len)
+{
+  memcpy(buf, image + convert_addr(addr), len);
+}
+
+void write_image(long addr, const unsigned char *buf, int len)
+{
+  if (memcmp(image + convert_addr(addr), buf, len) == 0) // 内容が変わらないときは dirty にしない
+    return;
+  memcpy(image + convert_addr(addr), buf, len);
+  dirty[addr / fmt.bps] = 1;
+}
 
 char name[8 + 1] = {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' ', '\0'}; // ' ' = 20
 char extension[3 + 1] = {' ', ' ', ' ', '\0'};
 
+/* separate_name() */
+// cpm_filename からディレクトリ部分を除き、名前と拡張子に分ける。
+// 複数のファイルを続けて書き込むので、毎回 space で埋め直してから詰める。
 void separate_name()
 {
-  char *ext = strrchr(cpm_filename, '.') + 1;
+  char *base = cpm_filename;
+  char *p, *dot;
+  const char *ext;
   int len, i;
 
-  len = strlen(cpm_filename) - strlen(ext) - 1;
+  for (p = cpm_filename; *p; p++)
+    if (*p == '/' || *p == '\\')
+      base = p + 1;
+  dot = strrchr(base, '.');
+  len = dot ? dot - base : (int)strlen(base);
+  ext = dot ? dot + 1 : "";
+
+  memset(name, ' ', 8);
+  memset(extension, ' ', 3);
+
   for (i = 0; i < (len < 8 ? len : 8); i++)
-    name[i] = toupper(cpm_filename[i]);
+    name[i] = toupper(base[i]);
 
   len = strlen(ext);
   for (i = 0; i < (len < 3 ? len : 3); i++)
     extension[i] = toupper(ext[i]);
 }
 
-int head_addr_of_data_block(int block_number)
+long head_addr_of_data_block(int block_number)
 {
-  return BPS * SPT * 2 + DATA_BLOCK_SIZE * block_number;
+  return (long)fmt.bps * fmt.spt * fmt.off + (long)fmt.bls * block_number;
 }
 
-int head_addr_of_FCB(int FCB_number)
+long head_addr_of_FCB(int FCB_number)
 {
   return head_addr_of_data_block(0) + 32 * FCB_number;
 }
 
-int head_addr_of_record(int record_number)
+long head_addr_of_record(long record_number)
 {
   return head_addr_of_data_block(record_number / RPD) + 128 * (record_number % RPD);
 }
 
+/* get_block_ptr(k), set_block_ptr(k, block_number) */
+// FCB_buff の a0 ~ aF の k 番目の data block 番号。
+// data block が 256 個を超えるディスクでは、一つが 2 バイト (下位, 上位) になり、8 個までしか入らない。
+int get_block_ptr(int k)
+{
+  if (blocks_per_FCB == 16)
+    return FCB_buff[16 + k];
+  return FCB_buff[16 + 2 * k] | FCB_buff[17 + 2 * k] << 8;
+}
+
+void set_block_ptr(int k, int block_number)
+{
+  if (blocks_per_FCB == 16)
+    FCB_buff[16 + k] = block_number;
+  else
+  {
+    FCB_buff[16 + 2 * k] = block_number & 0xFF;
+    FCB_buff[17 + 2 * k] = block_number >> 8;
+  }
+}
+
 int is_name_ext()
 {
   int i;
@@ -147,39 +503,126 @@ int is_name_ext()
   return 1;
 }
 
-int last_living_block_num = 1; // 書き込んだ内容が生き残っている data block の最後の番号。
-int last_living_FCB_num = -1;  // それに対応する FCB の番号。初期値 -1 は、存在しない場合。
+/* 割り当て表 */
+// block_map[b] : data block b が使用中なら 1。ディレクトリの data block (0 番と 1 番) は常に 1。
+// FCB_map[i]   : FCB i が使用中なら 1。
+// どちらも起動時に scan_directory() で一度だけ作り、以後は write_in() が更新していく。
+char *block_map = NULL;
+char *FCB_map = NULL;
+
+int is_living_FCB()
+{
+  return FCB_buff[0] != 0xE5;
+}
+
+/* free_image() */
+// load_image() と scan_directory() で確保したものをすべて解放する。
+void free_image()
+{
+  free(image);
+  free(dirty);
+  free(sector_offset);
+  free(block_map);
+  free(FCB_map);
+  image = NULL;
+  dirty = NULL;
+  sector_offset = NULL;
+  block_map = NULL;
+  FCB_map = NULL;
+}
+
+/* scan_directory() */
+// 生きている FCB すべての a0 ~ aF から、block_map と FCB_map を作る。
+void scan_directory()
+{
+  block_map = calloc(num_of_data_blocks, 1);
+  FCB_map = calloc(num_of_FCBs, 1);
+  memset(block_map, 1, fmt.dir_blocks);
+
+  for (int i = 0; i < num_of_FCBs; i++)
+  {
+    read_image(head_addr_of_FCB(i), FCB_buff, 32);
+
+    if (is_living_FCB())
+    {
+      FCB_map[i] = 1;
+      for (int j = 0; j < blocks_per_FCB; j++)
+        if (get_block_ptr(j) < num_of_data_blocks)
+          block_map[get_block_ptr(j)] = 1;
+    }
+  }
+}
 
 /* same_name_check() */
 // 同じ名前のファイルがすでにあるかチェック。もしあるなら書き込まない。
-// last_living_FCB_num, last_living_block_num の更新も行う。
+// 同じ起動の中で先に書き込んだファイルも image 上にあるので、それとの重複も見つかる。
 int same_name_check()
 {
-  FILE *fp = NULL;
-  fp = fopen(image_filename, "rb");
-
-  int r = 0;
-
   for (int i = 0; i < num_of_FCBs; i++)
   {
-    fseek(fp, convert_addr(head_addr_of_FCB(i)), SEEK_SET);
-    fread(FCB_buff, 1, 32, fp);
+    if (!FCB_map[i])
+      continue;
+    read_image(head_addr_of_FCB(i), FCB_buff, 32);
+
+    if (FCB_buff[0] == 0 && is_name_ext()) // living FCB
+      return 1;
+  }
+
+  return 0;
+}
 
-    if (FCB_buff[0] == 0) // living FCB
+/* allocate_blocks(blocks, list) */
+// 空いている data block を blocks 個選び、list に書き出す。足りなければ 0 を返す。
+// blocks 個以上続いている空き領域のうち最も短いもの (best fit) があれば、そこに連続して置く。
+// どこにも収まらないときは、番号の小さい空き block から順に使う (first fit)。
+// block_map には印をつけない（書き込みが成功してから write_in() がつける）。
+int allocate_blocks(int blocks, int *list)
+{
+  int best = -1, best_len = 0, free_blocks = 0;
+  int b, tail, i;
+
+  for (b = fmt.dir_blocks; b < num_of_data_blocks; b = tail)
+  {
+    if (block_map[b])
     {
-      last_living_FCB_num = i;
-      if (is_name_ext())
-        r = 1;
-      for (int j = 16; j < 32; j++)
-        if (last_living_block_num < FCB_buff[j])
-        {
-          last_living_block_num = FCB_buff[j];
-        }
+      tail = b + 1;
+      continue;
+    }
+    for (tail = b; tail < num_of_data_blocks && !block_map[tail]; tail++)
+      ;
+    free_blocks += tail - b;
+    if (tail - b >= blocks && (best < 0 || tail - b < best_len))
+    {
+      best = b;
+      best_len = tail - b;
     }
   }
+  if (free_blocks < blocks)
+    return 0;
 
-  fclose(fp);
-  return r;
+  if (best >= 0)
+  {
+    for (i = 0; i < blocks; i++)
+      list[i] = best + i;
+    return 1;
+  }
+
+  for (b = fmt.dir_blocks, i = 0; i < blocks; b++)
+    if (!block_map[b])
+      list[i++] = b;
+  return 1;
+}
+
+/* allocate_FCBs(FCBs, list) */
+// 空いている FCB（先頭が E5 のもの）を番号の小さい順に FCBs 個選ぶ。足りなければ 0 を返す。
+int allocate_FCBs(int FCBs, int *list)
+{
+  int i, n = 0;
+
+  for (i = 0; i < num_of_FCBs && n < FCBs; i++)
+    if (!FCB_map[i])
+      list[n++] = i;
+  return n == FCBs;
 }
 
 void init_FCB_buf()
@@ -195,94 +638,663 @@ void init_FCB_buf()
     FCB_buff[i] = 0;
 }
 
+/* set_FCB_extent(k, records) */
+// FCB_buff を、ファイルの k 番目 (0 から) の FCB として、そこに records 個のレコードが入っているものにする。
+// LE はその FCB の最後の 16k バイト単位の extend の番号（32 以上は上位を 0EH 番地に置く）、
+// NR はその extend のレコード数。
+void set_FCB_extent(int k, int records)
+{
+  int extent = k * extents_per_FCB + (records > 0 ? (records - 1) / 128 : 0);
+
+  FCB_buff[12] = extent & 0x1F;
+  FCB_buff[14] = extent >> 5;
+  FCB_buff[15] = records % 128 ? records % 128 : (records ? 0x80 : 0);
+}
+
 void init_record_buf()
 {
   for (int i = 0; i < 128; i++)
     record_buff[i] = 0x1A;
 }
 
-void save_FCB(FILE *fp, int FCB_number)
+void save_FCB(int FCB_number)
 {
-  fseek(fp, convert_addr(head_addr_of_FCB(FCB_number)), SEEK_SET);
-  fwrite(FCB_buff, 1, 32, fp);
+  write_image(head_addr_of_FCB(FCB_number), FCB_buff, 32);
 }
 
-void save_record(FILE *fp, int record_number)
+void save_record(int record_number)
 {
-  fseek(fp, convert_addr(head_addr_of_record(record_number)), SEEK_SET);
-  fwrite(record_buff, 1, 128, fp);
+  write_image(head_addr_of_record(record_number), record_buff, 128);
+}
+
+/* find_file(list) */
+// name, extension のファイルの FCB をすべて集め、extend の順に並べて list に書き出す。
+// 見つかった FCB の数を返す（ないときは 0）。
+int extent_of_FCB(int FCB_number)
+{
+  read_image(head_addr_of_FCB(FCB_number), FCB_buff, 32);
+  return (FCB_buff[12] & 0x1F) + 32 * FCB_buff[14];
+}
+
+int find_file(int *list)
+{
+  int i, j, n = 0;
+
+  for (i = 0; i < num_of_FCBs; i++)
+  {
+    if (!FCB_map[i])
+      continue;
+    read_image(head_addr_of_FCB(i), FCB_buff, 32);
+    if (FCB_buff[0] != 0 || !is_name_ext())
+      continue;
+
+    int extent = extent_of_FCB(i);
+    for (j = n; j > 0 && extent_of_FCB(list[j - 1]) > extent; j--)
+      list[j] = list[j - 1];
+    list[j] = i;
+    n++;
+  }
+
+  return n;
 }
 
-void write_in()
+/* file_blocks(FCB_list, FCBs, block_list) */
+// FCB の並び FCB_list から、使用している data block を順に block_list に書き出し、レコードの数を返す。
+// 一つの FCB が使っているレコードの数は (LE & EXM) * 128 + NR（NR = 80H は 128 レコード）。
+long file_blocks(int *FCB_list, int FCBs, int *block_list)
+{
+  long records = 0;
+  int i, k, n = 0;
+
+  for (i = 0; i < FCBs; i++)
+  {
+    read_image(head_addr_of_FCB(FCB_list[i]), FCB_buff, 32);
+    int used = (FCB_buff[12] & (extents_per_FCB - 1)) * 128 + FCB_buff[15];
+    if (used > records_per_FCB)
+      used = records_per_FCB;
+
+    for (k = 0; k < (used + RPD - 1) / RPD; k++)
+      block_list[n++] = get_block_ptr(k);
+    records += used;
+    if (used < records_per_FCB) // 満杯でない FCB はファイルの最後
+      break;
+  }
+
+  return records;
+}
+
+/* mark_file(FCB_list, FCBs, used) */
+// FCB_list の FCB と、それらが指す data block の使用中の印を used にする。
+void mark_file(int *FCB_list, int FCBs, int used)
+{
+  for (int i = 0; i < FCBs; i++)
+  {
+    FCB_map[FCB_list[i]] = used;
+    read_image(head_addr_of_FCB(FCB_list[i]), FCB_buff, 32);
+    for (int j = 0; j < blocks_per_FCB; j++)
+      if (get_block_ptr(j) >= fmt.dir_blocks && get_block_ptr(j) < num_of_data_blocks)
+        block_map[get_block_ptr(j)] = used;
+  }
+}
+
+/* write_in() */
+// 書き込みはすべて image 上で行う。成功したら 1 を返し、呼び出し側が最後に flush_image() する。
+// 必要な data block と FCB は書き始める前にすべて確保するので、容量不足なら何も書かない。
+// replace のときは同じ名前のファイルを置き換える。新しい内容が元の block に収まるなら同じ block と FCB に
+// 書き直すので、変わったレコードのセクタだけが dirty になる。
+int write_in()
 {
   separate_name();
-  if (same_name_check())
+  if (same_name_check() && !replace)
   {
-    printf("A same name file exists. Cancel writing.\n");
-    return;
+    fprintf(msg, "A same name file exists. Cancel writing.\n");
+    return 0;
   }
 
-  FILE *wfp = NULL;
   FILE *rfp = NULL;
-  wfp = fopen(image_filename, "r+b"); // 部分的な上書きができないといけない。
   rfp = fopen(cpm_filename, "rb");
+  if (rfp == NULL)
+  {
+    fprintf(msg, "Cannot open %s.\n", cpm_filename);
+    return 0;
+  }
 
-  int used_FCBs = 0;
-  int written_records = 0;
+  fseek(rfp, 0, SEEK_END);
+  long size = ftell(rfp);
   fseek(rfp, 0, SEEK_SET);
-  int count = 0;
+  long records = (size + 127) / 128;
+  int blocks = records / RPD + (records % RPD ? 1 : 0);
+
+  int FCBs = records ? (records + records_per_FCB - 1) / records_per_FCB : 1;
+  int *block_list = malloc(sizeof(int) * num_of_data_blocks);
+  int *FCB_list = malloc(sizeof(int) * num_of_FCBs);
+  int *old_block_list = malloc(sizeof(int) * num_of_data_blocks);
+  int *old_FCB_list = malloc(sizeof(int) * num_of_FCBs);
+  int old_FCBs = replace ? find_file(old_FCB_list) : 0;
+  long old_records = file_blocks(old_FCB_list, old_FCBs, old_block_list);
+  int old_blocks = old_records / RPD + (old_records % RPD ? 1 : 0);
+  int i, j;
+
+  mark_file(old_FCB_list, old_FCBs, 0);
+  if (blocks <= old_blocks && FCBs <= old_FCBs)
+  {
+    memcpy(block_list, old_block_list, sizeof(int) * blocks);
+    memcpy(FCB_list, old_FCB_list, sizeof(int) * FCBs);
+  }
+  else if (blocks > num_of_data_blocks || FCBs > num_of_FCBs || !allocate_blocks(blocks, block_list) || !allocate_FCBs(FCBs, FCB_list))
+  {
+    fprintf(msg, "Not enough capacity. Cancel writing.\n");
+    mark_file(old_FCB_list, old_FCBs, 1);
+    free(block_list);
+    free(FCB_list);
+    free(old_block_list);
+    free(old_FCB_list);
+    fclose(rfp);
+    return 0;
+  }
+
+  // 使わなくなった元の FCB を消す
+  unsigned char deleted = 0xE5;
+  for (i = 0; i < old_FCBs; i++)
+  {
+    for (j = 0; j < FCBs && FCB_list[j] != old_FCB_list[i]; j++)
+      ;
+    if (j == FCBs)
+      write_image(head_addr_of_FCB(old_FCB_list[i]), &deleted, 1);
+  }
+  free(old_block_list);
+  free(old_FCB_list);
+
+  // FCB は records_per_FCB レコードごとに一つ。埋まったものから順に書き出す。
+  long written_records = 0;
+  int k = 0;
   init_FCB_buf();
+  set_FCB_extent(0, 0);
   init_record_buf();
-  while (fread(record_buff, 1, 128, rfp))
+  while (written_records < records && fread(record_buff, 1, 128, rfp))
   {
-    if (last_living_FCB_num + used_FCBs >= num_of_FCBs || RPD * (last_living_block_num + 1) + written_records >= RPD * num_of_data_blocks)
-    {
-      printf("Not enough capacity. The writing is incomplete.\n");
-      return;
-    }
-
-    save_record(wfp, RPD * (last_living_block_num + 1) + written_records);
+    int b = block_list[written_records / RPD];
+    save_record(RPD * b + written_records % RPD);
+    set_block_ptr(written_records / RPD % blocks_per_FCB, b);
+    block_map[b] = 1;
     written_records++;
-    FCB_buff[12] = used_FCBs;
-    FCB_buff[15] = written_records % 128 ? written_records % 128 : 0x80;
-    int written_blocks = written_records / RPD + (written_records % RPD ? 1 : 0);
-    int offset = (16 + written_blocks - 1) % 16;
-    FCB_buff[16 + offset] = last_living_block_num + written_blocks;
-
-    if (written_records % 128 == 0)
-      used_FCBs++;
-    if (written_records == BPS)
+    set_FCB_extent(k, (written_records - 1) % records_per_FCB + 1);
+
+    if (written_records % records_per_FCB == 0 && written_records < records)
     {
-      save_FCB(wfp, last_living_FCB_num + 1 + used_FCBs % 2);
+      save_FCB(FCB_list[k]);
+      FCB_map[FCB_list[k]] = 1;
       init_FCB_buf();
+      k++;
     }
 
     init_record_buf();
   }
-  save_FCB(wfp, last_living_FCB_num + 1 + used_FCBs % 2);
+  save_FCB(FCB_list[k]);
+  FCB_map[FCB_list[k]] = 1;
 
+  free(FCB_list);
+  free(block_list);
   fclose(rfp);
-  fclose(wfp);
-  printf("Done.\n");
+  return 1;
+}
+
+/* write_list(list_filename) */
+// 一行に一つずつファイル名を書いたリストファイルに従って書き込む。
+// 空行と '#' で始まる行は読み飛ばす。失敗したファイルの数を返す。
+int write_list(char *list_filename)
+{
+  FILE *fp = fopen(list_filename, "r");
+  char line[FILENAME_MAX];
+  int failed = 0;
+
+  if (fp == NULL)
+  {
+    fprintf(msg, "Cannot open %s.\n", list_filename);
+    return 1;
+  }
+
+  while (fgets(line, sizeof(line), fp))
+  {
+    line[strcspn(line, "\r\n")] = '\0';
+    if (line[0] == '\0' || line[0] == '#')
+      continue;
+
+    cpm_filename = line;
+    fprintf(msg, "%s --> %s\n", cpm_filename, image_filename);
+    if (!write_in())
+      failed++;
+  }
+
+  fclose(fp);
+  return failed;
+}
+
+
+/* file_byte(block_list, pos) */
+// ファイルの先頭から pos バイト目の値。
+int file_byte(int *block_list, long pos)
+{
+  long record_number = pos / 128;
+  return image[convert_addr(head_addr_of_data_block(block_list[record_number / RPD]) + 128 * (record_number % RPD) + pos % 128)];
+}
+
+/* get_out(out_filename, strip) */
+// cpm_filename のファイルをイメージから取り出し、out_filename（NULL なら標準出力）に書き出す。
+// strip が 1 なら、末尾の 1A の詰め物を取り除く。
+// 取り出しは 16k バイト（16k バイト単位の extend 一つ分）ずつまとめて書き出す。
+#define GET_CHUNK 16384
+
+int get_out(char *out_filename, int strip)
+{
+  int *FCB_list = malloc(sizeof(int) * num_of_FCBs);
+  int *block_list = malloc(sizeof(int) * num_of_data_blocks);
+
+  separate_name();
+  int FCBs = find_file(FCB_list);
+  long records = FCBs ? file_blocks(FCB_list, FCBs, block_list) : 0;
+  free(FCB_list);
+  if (FCBs == 0)
+  {
+    fprintf(msg, "%s is not found.\n", cpm_filename);
+    free(block_list);
+    return 0;
+  }
+
+  long length = records * 128;
+  if (strip)
+    while (length > 0 && file_byte(block_list, length - 1) == 0x1A)
+      length--;
+
+  FILE *out = out_filename ? fopen(out_filename, "wb") : stdout;
+  if (out == NULL)
+  {
+    fprintf(msg, "Cannot open %s.\n", out_filename);
+    free(block_list);
+    return 0;
+  }
+
+  unsigned char *chunk = malloc(GET_CHUNK);
+  long pos = 0;
+  int filled = 0;
+  for (long i = 0; pos < length; i++)
+  {
+    int bytes = length - pos < 128 ? (int)(length - pos) : 128;
+    memcpy(chunk + filled, image + convert_addr(head_addr_of_data_block(block_list[i / RPD]) + 128 * (i % RPD)), bytes);
+    filled += bytes;
+    pos += bytes;
+    if (filled == GET_CHUNK)
+    {
+      fwrite(chunk, 1, filled, out);
+      filled = 0;
+    }
+  }
+  fwrite(chunk, 1, filled, out);
+
+  if (out_filename)
+    fclose(out);
+  else
+    fflush(out);
+  free(chunk);
+  free(block_list);
+  return 1;
+}
+
+/* print_runs(block_list, blocks) */
+// data block の並びを、連続した部分ごとに "2-5,9" のようにまとめて表示する。連続した部分の数を返す。
+int print_runs(int *block_list, int blocks)
+{
+  int i, j, runs = 0;
+
+  for (i = 0; i < blocks; i = j + 1)
+  {
+    for (j = i; j + 1 < blocks && block_list[j + 1] == block_list[j] + 1; j++)
+      ;
+    printf(runs++ ? "," : " ");
+    if (i == j)
+      printf("%d", block_list[i]);
+    else
+      printf("%d-%d", block_list[i], block_list[j]);
+  }
+
+  return runs;
+}
+
+/* first_FCB_of_file(FCB_number) */
+// FCB_number がファイルの最初の FCB なら、そのファイル名を name, extension に入れて 1 を返す。
+// 同じファイルの FCB は、番号の最も小さいものだけを「最初」とする。
+int first_FCB_of_file(int FCB_number)
+{
+  int j;
+
+  if (!FCB_map[FCB_number])
+    return 0;
+  read_image(head_addr_of_FCB(FCB_number), FCB_buff, 32);
+  if (FCB_buff[0] != 0)
+    return 0;
+
+  memcpy(name, FCB_buff + 1, 8);
+  memcpy(extension, FCB_buff + 9, 3);
+  for (j = 0; j < FCB_number; j++)
+  {
+    read_image(head_addr_of_FCB(j), FCB_buff, 32);
+    if (FCB_map[j] && FCB_buff[0] == 0 && is_name_ext())
+      return 0;
+  }
+
+  return 1;
+}
+
+/* list_files() */
+// すべてのファイルについて、大きさ、FCB の数と data block の並びを表示し、
+// 最後に空き data block の数、最も長い連続した空き領域、断片化で使いにくくなっている空きの数を表示する。
+// 断片化した空きとは、最も長い連続した空き領域以外にある空き data block のこと。
+void list_files()
+{
+  int *FCB_list = malloc(sizeof(int) * num_of_FCBs);
+  int *block_list = malloc(sizeof(int) * num_of_data_blocks);
+  int i, files = 0, used_FCBs = 0;
+
+  printf("NAME     EXT      BYTES  FCBS  BLOCKS\n");
+  for (i = 0; i < num_of_FCBs; i++)
+  {
+    used_FCBs += FCB_map[i];
+    if (!first_FCB_of_file(i))
+      continue;
+
+    int FCBs = find_file(FCB_list);
+    long records = file_blocks(FCB_list, FCBs, block_list);
+    int blocks = records / RPD + (records % RPD ? 1 : 0);
+    printf("%s %s %10ld %5d ", name, extension, records * 128, FCBs);
+    int runs = print_runs(block_list, blocks);
+    if (runs > 1)
+      printf("  (%d fragments)", runs);
+    printf("\n");
+    files++;
+  }
+
+  int free_blocks = 0, largest = 0, largest_head = 0, b, tail;
+  for (b = fmt.dir_blocks; b < num_of_data_blocks; b = tail)
+  {
+    if (block_map[b])
+    {
+      tail = b + 1;
+      continue;
+    }
+    for (tail = b; tail < num_of_data_blocks && !block_map[tail]; tail++)
+      ;
+    free_blocks += tail - b;
+    if (tail - b > largest)
+    {
+      largest = tail - b;
+      largest_head = b;
+    }
+  }
+
+  printf("\n%d files, %d/%d FCBs used, %d-byte blocks\n", files, used_FCBs, num_of_FCBs, fmt.bls);
+  printf("%d/%d blocks free", free_blocks, num_of_data_blocks - fmt.dir_blocks);
+  if (largest)
+    printf(", largest free run %d blocks (%d-%d)", largest, largest_head, largest_head + largest - 1);
+  printf(", %d blocks lost to fragmentation\n", free_blocks - largest);
+
+  free(FCB_list);
+  free(block_list);
+}
+
+/* repack() */
+// 生きているファイルをすべて読み、data block 2 番から順に隙間なく置き直し、ディレクトリも前から詰めて作り直す。
+// 新しいイメージは全体を一時ファイルに一度に書き、rename で元のファイルと置き換える。
+// ほかのユーザー番号のファイルがあるときは、何もしない。
+struct packed_file
+{
+  unsigned char head[12]; // DR, n0 ~ n7, e0 ~ e2
+  long records;
+  int *block_list;
+};
+
+int repack()
+{
+  struct packed_file *files = malloc(sizeof(struct packed_file) * num_of_FCBs);
+  int *FCB_list = malloc(sizeof(int) * num_of_FCBs);
+  int i, n = 0, r = 0;
+
+  for (i = 0; i < num_of_FCBs; i++)
+  {
+    read_image(head_addr_of_FCB(i), FCB_buff, 32);
+    if (FCB_map[i] && FCB_buff[0] != 0)
+    {
+      fprintf(msg, "Files of other user numbers exist. Cancel repacking.\n");
+      n = -1;
+      break;
+    }
+    if (!first_FCB_of_file(i))
+      continue;
+
+    files[n].block_list = malloc(sizeof(int) * num_of_data_blocks);
+    files[n].records = file_blocks(FCB_list, find_file(FCB_list), files[n].block_list);
+    read_image(head_addr_of_FCB(i), files[n].head, 12);
+    n++;
+  }
+  free(FCB_list);
+
+  if (n >= 0)
+  {
+    unsigned char *old = malloc(image_size);
+    unsigned char blank[32];
+    int next_block = fmt.dir_blocks, next_FCB = 0;
+
+    memcpy(old, image, image_size);
+    memset(blank, 0xE5, 32);
+    for (i = 0; i < num_of_FCBs; i++)
+      write_image(head_addr_of_FCB(i), blank, 32);
+
+    for (i = 0; i < n; i++)
+    {
+      struct packed_file *f = &files[i];
+      int k = 0;
+
+      memcpy(name, f->head + 1, 8);
+      memcpy(extension, f->head + 9, 3);
+      init_FCB_buf();
+      set_FCB_extent(0, 0);
+      for (long j = 0; j < f->records; j++)
+      {
+        memcpy(record_buff, old + convert_addr(head_addr_of_data_block(f->block_list[j / RPD]) + 128 * (j % RPD)), 128);
+        save_record(RPD * next_block + j % RPD);
+        set_block_ptr(j / RPD % blocks_per_FCB, next_block);
+        set_FCB_extent(k, j % records_per_FCB + 1);
+        if ((j + 1) % RPD == 0 || j + 1 == f->records)
+          next_block++;
+        if ((j + 1) % records_per_FCB == 0 && j + 1 < f->records)
+        {
+          save_FCB(next_FCB++);
+          init_FCB_buf();
+          k++;
+        }
+      }
+      save_FCB(next_FCB++);
+    }
+    free(old);
+
+    char *tmp_filename = malloc(strlen(image_filename) + 5);
+    sprintf(tmp_filename, "%s.tmp", image_filename);
+    FILE *fp = fopen(tmp_filename, "wb");
+    if (fp == NULL)
+      fprintf(msg, "Cannot write %s.\n", tmp_filename);
+    else if (fwrite(image, 1, image_size, fp) != (size_t)image_size || fclose(fp) != 0)
+    {
+      fprintf(msg, "Cannot write %s.\n", tmp_filename);
+      remove(tmp_filename);
+    }
+    else if (rename(tmp_filename, image_filename) != 0)
+    {
+      fprintf(msg, "Cannot replace %s.\n", image_filename);
+      remove(tmp_filename);
+    }
+    else
+      r = 1;
+    free(tmp_filename);
+    memset(dirty, 0, num_of_sectors);
+  }
+
+  for (i = 0; i < n; i++)
+    free(files[i].block_list);
+  free(files);
+  return r;
 }
 
 int main(int argc, char *argv[])
 {
-  switch (argc)
+  int failed = 0;
+  int arg = 1;
+  int strip = 0;
+
+  msg = stdout;
+
+  // オプション
+  while (arg < argc && argv[arg][0] == '-')
   {
-  case 1:
-    printf("Usage:\n");
-    printf(" ./<this program name> <.d88 file name> <CP/M-80 file name> [RETURN]\n");
-    printf(" It writes the file <CP/M-80 file name> into the file <.d88 file name> for PC-8801 emulators.\n");
+    if (strcmp(argv[arg], "-f") == 0 && arg + 1 < argc)
+    {
+      if (!select_format(argv[arg + 1]))
+        return 1;
+      arg += 2;
+    }
+    else if (strcmp(argv[arg], "-t") == 0)
+    {
+      strip = 1;
+      arg++;
+    }
+    else if (strcmp(argv[arg], "--replace") == 0)
+    {
+      replace = 1;
+      arg++;
+    }
+    else
+    {
+      printf("Invalid arguments.\n");
+      return 1;
+    }
+  }
+
+  // get <.d88 file name> <CP/M-80 file name> [<output file name>]
+  if (arg < argc && strcmp(argv[arg], "get") == 0)
+  {
+    if (argc - arg != 3 && argc - arg != 4)
+    {
+      printf("Invalid arguments.\n");
+      return 1;
+    }
+    image_filename = argv[arg + 1];
+    cpm_filename = argv[arg + 2];
+    char *out_filename = argc - arg == 4 && strcmp(argv[arg + 3], "-") != 0 ? argv[arg + 3] : NULL;
+    if (out_filename == NULL)
+      msg = stderr;
+    else
+      fprintf(msg, "%s --> %s\n", image_filename, out_filename);
+
+    if (!load_image())
+    {
+      free_image();
+      return 1;
+    }
+    scan_directory();
+    failed = !get_out(out_filename, strip);
+    free_image();
+    return failed;
+  }
+
+  // ls <.d88 file name>
+  if (arg < argc && strcmp(argv[arg], "ls") == 0)
+  {
+    if (argc - arg != 2)
+    {
+      printf("Invalid arguments.\n");
+      return 1;
+    }
+    image_filename = argv[arg + 1];
+    if (!load_image())
+    {
+      free_image();
+      return 1;
+    }
+    scan_directory();
+    list_files();
+    free_image();
     return 0;
-  case 3:
-    image_filename = argv[1];
-    cpm_filename = argv[2];
-    printf("%s --> %s\n", cpm_filename, image_filename);
-    write_in();
+  }
+
+  // repack <.d88 file name>
+  if (arg < argc && strcmp(argv[arg], "repack") == 0)
+  {
+    if (argc - arg != 2)
+    {
+      printf("Invalid arguments.\n");
+      return 1;
+    }
+    image_filename = argv[arg + 1];
+    if (!load_image())
+    {
+      free_image();
+      return 1;
+    }
+    scan_directory();
+    failed = !repack();
+    if (!failed)
+      printf("Done.\n");
+    free_image();
+    return failed;
+  }
+
+  switch (argc - arg)
+  {
+  case 0:
+    printf("Usage:\n");
+    printf(" ./<this program name> [-f <format>] [--replace] <.d88 file name> <CP/M-80 file name> ... [RETURN]\n");
+    printf(" ./<this program name> [-f <format>] [--replace] <.d88 file name> @<list file name> [RETURN]\n");
+    printf(" It writes the files <CP/M-80 file name> ... into the file <.d88 file name> for PC-8801 emulators.\n");
+    printf(" A list file names one CP/M-80 file per line.\n");
+    printf(" --replace overwrites the files of the same names, rewriting only the changed records if possible.\n");
+    printf(" ./<this program name> [-f <format>] [-t] get <.d88 file name> <CP/M-80 file name> [<output file name>] [RETURN]\n");
+    printf(" It reads the file <CP/M-80 file name> out of <.d88 file name> (to the standard output without <output file name>).\n");
+    printf(" -t strips the trailing 1AH padding.\n");
+    printf(" ./<this program name> [-f <format>] ls <.d88 file name> [RETURN]\n");
+    printf(" It lists the files, their blocks and the free space of <.d88 file name>.\n");
+    printf(" ./<this program name> [-f <format>] repack <.d88 file name> [RETURN]\n");
+    printf(" It rewrites <.d88 file name> with every file in contiguous blocks.\n");
+    printf(" <format> is 2d, 8inch or bps,spt,tracks,off,bls,dir_blocks[,skew].\n");
+    printf(" Without -f, the format is detected from the .d88 header.\n");
     return 0;
-  default:
+  case 1:
     printf("Invalid arguments.\n");
     return 1;
+  default:
+    image_filename = argv[arg];
+    if (!load_image())
+    {
+      free_image();
+      return 1;
+    }
+    scan_directory();
+
+    for (int i = arg + 1; i < argc; i++)
+    {
+      if (argv[i][0] == '@')
+      {
+        failed += write_list(argv[i] + 1);
+        continue;
+      }
+      cpm_filename = argv[i];
+      printf("%s --> %s\n", cpm_filename, image_filename);
+      if (!write_in())
+        failed++;
+    }
+
+    if (!flush_image())
+      failed++;
+    else if (!failed)
+      printf("Done.\n");
+    free_image();
+    return failed ? 1 : 0;
   }
 }